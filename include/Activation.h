@@ -0,0 +1,23 @@
+#ifndef Activation_h
+#define Activation_h
+
+#include "Common.h"
+
+// A bound on the absolute difference between fastTanhf and tanhf. Over every
+// float the largest difference is 4.2e-7, at about 5.74, and --bench-nets
+// checks a sample of them on each run.
+#define FAST_TANH_MAX_ERROR 5e-7f
+
+// The largest absolute difference between an output neuron evaluated with the
+// fast and the exact activation that --compare-activation accepts. Errors in
+// internal neurons are scaled by the weights downstream, so this is looser
+// than FAST_TANH_MAX_ERROR.
+#define FAST_TANH_MAX_OUTPUT_DIVERGENCE 1e-4f
+
+float fastTanhf(float x);
+bool parseActivation(const char* name, ActivationMode* activation);
+const char* getActivationName(ActivationMode activation);
+float activate(float x, ActivationMode activation);
+void activateLanes(float* x, int count, float divisor, ActivationMode activation);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef Arena_h
+#define Arena_h
+
+#include "Common.h"
+
+// Every allocation is rounded up to this, so that whatever follows it stays
+// aligned.
+#define ARENA_ALIGNMENT 16
+
+// One block of memory that is handed out front to back and given back all at
+// once. Each generation's genes and neurons live in one, packed organism by
+// organism, and it is reset when the generation is replaced.
+typedef struct {
+    char* base;
+
+    // sizes in bytes
+    size_t capacity;
+    size_t used;
+    size_t peak;
+} Arena;
+
+Arena createArena(size_t capacity);
+void destroyArena(Arena* arena);
+void resetArena(Arena* arena);
+void* arenaAlloc(Arena* arena, size_t bytes);
+
+static inline size_t getArenaAllocationBytes(size_t bytes)
+{
+    return (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+#endif
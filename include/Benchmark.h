@@ -0,0 +1,12 @@
+#ifndef Benchmark_h
+#define Benchmark_h
+
+#include "Common.h"
+
+int runNetBenchmark(Simulation* sim);
+int runPopulationBenchmark(Simulation* sim);
+int runGenomeBenchmark(Simulation* sim);
+int runCollisionBenchmark(Simulation* sim);
+int runIslandBenchmark(Simulation* sim);
+
+#endif
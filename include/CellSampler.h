@@ -0,0 +1,51 @@
+#ifndef CellSampler_h
+#define CellSampler_h
+
+#include "Common.h"
+#include "Random.h"
+
+// Worlds with more cells than this have no list of free cells, and organisms
+// are placed by picking random cells until one is free. At the limit the list
+// takes 64 MB.
+#define CELL_SAMPLER_MAX_CELLS (1 << 24)
+
+// Hands out distinct cells without obstacles in a random order, by shuffling
+// a list of them one draw at a time (a partial Fisher-Yates shuffle). The list
+// only ever holds some order of the free cells, so it doesn't need to be
+// rebuilt between rounds. cells is NULL if the world is too large for a list.
+typedef struct {
+    Size size;
+    uint32_t* cells;
+    uint32_t count;
+
+    // how many cells have been handed out this round
+    uint32_t drawn;
+} CellSampler;
+
+CellSampler createCellSampler(Simulation* sim);
+void destroyCellSampler(CellSampler* sampler);
+size_t countFreeCells(Simulation* sim);
+
+// Starts a round in which every free cell can be handed out once more.
+static inline void resetCellSampler(CellSampler* sampler)
+{
+    sampler->drawn = 0;
+}
+
+// Hands out a free cell that has not been handed out yet this round. There
+// must be one left.
+static inline Pos drawFreeCell(CellSampler* sampler, RandomStream* rng)
+{
+    uint32_t i = sampler->drawn++;
+    uint32_t j = i + randomBelow(rng, sampler->count - i);
+
+    uint32_t cell = sampler->cells[j];
+    sampler->cells[j] = sampler->cells[i];
+    sampler->cells[i] = cell;
+
+    return (Pos) {
+        .x = cell % sampler->size.w, .y = cell / sampler->size.w
+    };
+}
+
+#endif
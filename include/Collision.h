@@ -0,0 +1,28 @@
+#ifndef Collision_h
+#define Collision_h
+
+#include "Common.h"
+
+// An organism whose cell is taken settles in the nearest free cell within
+// COLLISION_SEARCH_RADIUS of it either way, or stays where it was if there is
+// none, so resolving a collision never looks at more than
+// COLLISION_SEARCH_CELLS cells.
+#define COLLISION_SEARCH_RADIUS 8
+#define COLLISION_SEARCH_SIDE (2 * COLLISION_SEARCH_RADIUS + 1)
+#define COLLISION_SEARCH_CELLS (COLLISION_SEARCH_SIDE * COLLISION_SEARCH_SIDE)
+
+typedef struct {
+    int8_t x;
+    int8_t y;
+} CollisionOffset;
+
+// The offsets from the contested cell in the order they are tried: ring by
+// ring of equal distance, each ring going round by angle. Ring r is
+// collisionSearchOrder[collisionRingStarts[r]] up to the start of ring r + 1.
+extern CollisionOffset collisionSearchOrder[COLLISION_SEARCH_CELLS];
+extern int collisionRingStarts[COLLISION_SEARCH_CELLS + 1];
+extern int collisionRingCount;
+
+void initCollisionSearch(void);
+
+#endif
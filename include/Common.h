@@ -14,6 +14,9 @@
 #define MAX_NEURONS 128
 #define MAX_CONNECTIONS 128
 
+// the longest side --world accepts
+#define MAX_WORLD_SIDE 65536
+
 typedef enum {
     DIR_N,
     DIR_NE,
@@ -48,13 +51,10 @@ typedef enum {
     OUT_MAX
 } OutputType;
 
-typedef struct {
-    bool sourceIsInput : 1;
-    uint8_t sourceId : 7;
-    bool sinkIsOutput : 1;
-    uint8_t sinkId : 7;
-    uint16_t weight;
-} Gene;
+// A gene is one packed word, from the top bit down: whether the source is an
+// input, the source id (7 bits), whether the sink is an output, the sink id
+// (7 bits) and the weight (16 bits). Genome.h reads the fields out.
+typedef uint32_t Gene;
 
 typedef struct {
     uint8_t count;
@@ -63,11 +63,18 @@ typedef struct {
 
 struct Neuron_t;
 
+// Connections are stored in the order they are evaluated. source and sink are
+// indices into the net's neurons. If divisor is non-zero, this connection is
+// the sink's last input and the sink is normalised straight after it by
+// dividing by its input count (a division rather than a multiplication by the
+// reciprocal, which would round differently).
 typedef struct {
     uint16_t sourceId;
     uint16_t sinkId;
+    uint16_t source;
+    uint16_t sink;
     float weight;
-    bool visited;
+    float divisor;
 } NeuralConnection;
 
 typedef enum {
@@ -82,65 +89,193 @@ typedef struct Neuron_t {
     float prevState;
     float state;
     uint8_t inputs;
-    uint8_t inputsVisited;
     uint8_t outputs;
-    uint8_t outputsVisited;
 } Neuron;
 
+// Only the first activeConnectionCount connections are ever evaluated. The
+// rest either have no path to an output neuron, or wait on an input that can
+// never complete, such as a self-loop or a cycle. They are kept so the net
+// still describes the whole genome.
 typedef struct {
     uint16_t neuronCount;
     Neuron *neurons;
     uint16_t connectionCount;
+    uint16_t activeConnectionCount;
     NeuralConnection *connections;
+
+    // one bit per InputType that an evaluated connection reads
+    uint32_t liveInputs;
+    uint16_t outputCount;
+
+    // the NetCache entry that owns the connections, or -1 if the net owns them
+    int cacheEntry;
 } NeuralNet;
 
 typedef struct {
-    int16_t x;
-    int16_t y;
+    int32_t x;
+    int32_t y;
 } Pos;
 
 typedef struct {
-    uint16_t w;
-    uint16_t h;
+    int32_t w;
+    int32_t h;
 } Size;
 
 typedef struct {
-    int16_t x;
-    int16_t y;
-    int16_t w;
-    int16_t h;
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
 } Rect;
 
-typedef uint16_t OrganismId;
+typedef struct {
+    uint64_t key;
+    int slot;
+} TileBucket;
+
+// Equally sized tiles of the world. A small world has every tile stored up
+// front, in row order. Otherwise tiles are only stored where something needs
+// them, they are found through an open-addressed hash of their coordinates,
+// and the slots of released tiles are reused before new ones are added.
+typedef struct {
+    size_t tileBytes;
+    char* tiles;
+    int capacity;
+
+    bool dense;
+    int32_t tilesAcross;
+
+    uint64_t* tileKeys;
+    int* nextFree;
+    int used;
+    int freeSlot;
+    int tileCount;
+    int peakTileCount;
+
+    TileBucket* buckets;
+    uint32_t bucketCount;
+    int bucketShift;
+} TileMap;
+
+// One bit per cell, set where the cell is an obstacle, in tiles that are
+// only stored where there is at least one obstacle.
+typedef struct {
+    Size size;
+    TileMap tiles;
+} ObstacleMap;
+
+// The inputs that only depend on an organism's position, worked out for every
+// cell up front. Each cell's values are stored together, in slot order, and
+// slots[input] is -1 for inputs that aren't position sensors. values is NULL
+// if the world is too large to tabulate.
+typedef struct {
+    Size size;
+    int8_t slots[IN_MAX];
+    int sensorCount;
+    float* values;
+} SensorField;
+
+// The cells the selector lets survive, one bit per cell in row order. bits is
+// NULL if the world is too large for a mask, and then the selector is called
+// for each organism instead.
+typedef struct {
+    Size size;
+    uint32_t* bits;
+} SelectionMask;
+
+typedef uint32_t OrganismId;
 
+// The parts of an organism that are fixed when it is born. What it does from
+// step to step is kept in an OrganismStore.
 typedef struct {
     OrganismId id;
-    Pos pos;
     Genome genome;
     NeuralNet net;
-    bool alive;
-    bool didCollide;
-    float energyLevel;
-    Direction direction;
     OrganismId parentA;
     OrganismId parentB;
     bool mutated;
 } Organism;
 
+// A generation of organisms, indexed by id. The state that changes every step
+// has one column per field, so that passes over the whole population only
+// read the fields they need, one after the other. Everything else is in orgs.
+typedef struct {
+    int count;
+    Pos* pos;
+    // where each organism was before it last moved
+    Pos* lastPos;
+    bool* alive;
+    bool* didCollide;
+    float* energyLevel;
+    Direction* direction;
+    Organism* orgs;
+} OrganismStore;
+
+typedef enum {
+    MATING_UNIFORM,
+    MATING_FITNESS,
+} MatingMode;
+
+// How likely each kind of mutation is, per gene of every offspring.
+typedef struct {
+    float bitFlip;
+    float weightPerturbation;
+    float duplication;
+} MutationRates;
+
+typedef enum {
+    NET_EVAL_SCALAR,
+    NET_EVAL_BATCHED,
+} NetEvaluator;
+
+// How neurons are normalised.
+typedef enum {
+    ACTIVATION_EXACT,
+    ACTIVATION_FAST,
+} ActivationMode;
+
+// Where the time of a run went, summed over every generation that was run.
+// Generations include their steps, selection, breeding and, in island mode,
+// the migrants exchanged, and steps include settling organisms into cells.
+// If stepSamples is set, the time of each of the first stepSampleCapacity
+// steps is kept in it.
+typedef struct {
+    int generations;
+    int steps;
+    uint64_t stepNanoseconds;
+    uint64_t actNanoseconds;
+    uint64_t generationNanoseconds;
+    uint64_t migrationNanoseconds;
+    uint64_t* stepSamples;
+    int stepSampleCapacity;
+} SimulationTimings;
+
 struct __simulation_t;
 
 typedef struct {
-    bool (*fn)(Organism*, struct __simulation_t*);
+    bool (*fn)(Pos, struct __simulation_t*);
     const char* name;
 } SelectionCriteria;
 
+typedef enum {
+    MIGRATION_RING,
+    MIGRATION_FULL,
+} MigrationTopology;
+
+struct Island_t;
+
 typedef struct __simulation_t {
     Size size;
     int seed;
     SelectionCriteria selector;
     Rect* obstacles;
     size_t obstaclesCount;
-    float mutationRate;
+    const char* obstacleMapFile;
+    ObstacleMap obstacleMap;
+    SensorField sensorField;
+    SelectionMask selectionMask;
+    MutationRates mutationRates;
+    MatingMode matingMode;
     float energyToMove;
     float energyToRest;
     int maxInternalNeurons;
@@ -148,6 +283,32 @@ typedef struct __simulation_t {
     int stepsPerGeneration;
     int numberOfGenes;
     int maxGenerations;
+    int threads;
+    NetEvaluator netEvaluator;
+    ActivationMode activation;
+    bool compareActivation;
+    ActivationMode comparedActivation;
+    bool headless;
+
+    // island mode evolves this many populations side by side, each of the
+    // given size, and every migrationInterval generations sends migrants
+    // organisms to each neighbour
+    int islands;
+    MigrationTopology migration;
+    int migrationInterval;
+    int migrants;
+
+    // run each island in its own process rather than on a thread, and pin
+    // the islands to these CPUs, one taskset list per island split by ':'
+    bool islandProcesses;
+    const char* islandCpus;
+
+    // the island this simulation is, or NULL outside island mode
+    struct Island_t* island;
+
+    // quiet runs only print a summary, and timings is filled in if it is set
+    bool quiet;
+    SimulationTimings* timings;
 } Simulation;
 
 #if FEATURE_TRACE
@@ -2,10 +2,11 @@
 #define Direction_h
 
 #include "Common.h"
+#include "Random.h"
 
 Direction turnLeft(Direction dir);
 Direction turnRight(Direction dir);
 Direction turnBackwards(Direction dir);
-Direction getRandomDirection(void);
+Direction getRandomDirection(RandomStream* rng);
 
 #endif
\ No newline at end of file
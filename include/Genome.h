@@ -2,10 +2,63 @@
 #define Genome_h
 
 #include "Common.h"
+#include "Random.h"
 
+#define GENE_SOURCE_IS_INPUT_SHIFT 31
+#define GENE_SOURCE_ID_SHIFT 24
+#define GENE_SINK_IS_OUTPUT_SHIFT 23
+#define GENE_SINK_ID_SHIFT 16
+#define GENE_ID_MASK 0x7f
+#define GENE_WEIGHT_MASK 0xffff
+
+static inline bool isGeneSourceInput(Gene gene)
+{
+    return (gene >> GENE_SOURCE_IS_INPUT_SHIFT) & 1;
+}
+
+static inline uint8_t getGeneSourceId(Gene gene)
+{
+    return (gene >> GENE_SOURCE_ID_SHIFT) & GENE_ID_MASK;
+}
+
+static inline bool isGeneSinkOutput(Gene gene)
+{
+    return (gene >> GENE_SINK_IS_OUTPUT_SHIFT) & 1;
+}
+
+static inline uint8_t getGeneSinkId(Gene gene)
+{
+    return (gene >> GENE_SINK_ID_SHIFT) & GENE_ID_MASK;
+}
+
+static inline uint16_t getGeneWeight(Gene gene)
+{
+    return gene & GENE_WEIGHT_MASK;
+}
+
+// Nudges to a weight are at most this far either way, out of 65536 steps
+// between -4 and +4.
+#define MUTATION_WEIGHT_STEP 2048
+
+// Schedules the mutations of one generation's offspring as if their genomes
+// were one long run of genes. The gap to the next mutation is drawn from a
+// geometric distribution, so genes that are not mutated cost nothing and the
+// rng is only drawn from once per mutation.
+typedef struct {
+    MutationRates rates;
+    float totalRate;
+    double logKeepRate;
+    RandomStream rng;
+
+    // genes left to go past before the next mutation
+    uint64_t gap;
+    uint64_t mutations;
+} MutationSchedule;
+
+MutationSchedule createMutationSchedule(MutationRates rates, RandomStream rng);
 Genome copyGenome(Genome* src, Gene* geneBuffer);
-Genome makeRandomGenome(uint8_t numGenes, Gene* geneBuffer);
-Genome mutateGenome(Genome genome, float mutationRate, bool* didMutate);
-Genome reproduce(Genome *a, Genome *b, Gene* geneBuffer);
+Genome makeRandomGenome(uint8_t numGenes, Gene* geneBuffer, RandomStream* rng);
+Genome mutateGenome(Genome genome, MutationSchedule* schedule, bool* didMutate);
+Genome reproduce(Genome *a, Genome *b, Gene* geneBuffer, RandomStream* rng);
 
 #endif
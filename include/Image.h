@@ -0,0 +1,8 @@
+#ifndef Image_h
+#define Image_h
+
+#include "Common.h"
+
+bool* readBitmapImage(const char* filename, int* w, int* h);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef Islands_h
+#define Islands_h
+
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "Common.h"
+#include "Survivors.h"
+
+// How many lots of migrants a mailbox holds, so that a sender can run this
+// many exchanges ahead of a slow receiver before it has to wait.
+#define MAILBOX_SLOTS 4
+
+// A one-way link from one island to another: a ring of MAILBOX_SLOTS lots of
+// migrants, each lot the packed genes of every migrant. The sender fills the
+// slot of an epoch once the receiver has taken the lot that was in it and
+// then publishes it by storing the epoch in posted, and the receiver stores
+// the same epoch in taken once it has copied them out, so neither ever takes
+// a lock. posted and taken sit on their own cache lines, since each is only
+// written from one side.
+typedef struct {
+    struct Island_t* sender;
+    struct Island_t* receiver;
+    Gene* genes;
+
+    _Alignas(64) int posted;
+    _Alignas(64) int taken;
+} Mailbox;
+
+// One population in island mode, evolved by runSimulation with its own copy
+// of the simulation, either on its own thread or in its own process. In
+// process mode the islands and their mailboxes live in shared memory.
+typedef struct Island_t {
+    int index;
+    Simulation sim;
+    SimulationTimings timings;
+    pthread_t thread;
+    pid_t process;
+    int status;
+
+    // whether thread was created, so that only those are joined
+    bool started;
+
+    // the CPUs to run on, as a taskset list, or NULL to run anywhere
+    const char* cpus;
+
+    Mailbox** outboxes;
+    int outboxCount;
+    Mailbox** inboxes;
+    int inboxCount;
+
+    // set once the island has stopped, so that its neighbours stop waiting
+    bool finished;
+
+    // the survivors of each generation, or -1 past the last one that ran
+    int* survivors;
+} Island;
+
+bool parseMigrationTopology(const char* name, MigrationTopology* topology);
+const char* getMigrationTopologyName(MigrationTopology topology);
+int runIslands(Simulation* sim);
+void exchangeMigrants(Island* island, OrganismStore* orgs, SurvivorIndex* survivors, int generation);
+void recordIslandGeneration(Island* island, int generation, int survivors);
+
+#endif
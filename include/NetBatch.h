@@ -0,0 +1,67 @@
+#ifndef NetBatch_h
+#define NetBatch_h
+
+#include "Common.h"
+#include "ThreadPool.h"
+
+// Organisms whose nets have exactly the same shape (the same connections
+// between the same neuron slots, in the same order) only differ in their
+// weights, so they are evaluated together NET_BATCH_LANES at a time.
+#define NET_BATCH_LANES 16
+
+// Groups smaller than this are cheaper to evaluate one organism at a time.
+#define NET_BATCH_MIN_GROUP 4
+
+typedef struct {
+    NeuralNet* shape;
+    int neuronCount;
+    int connectionCount;
+    int organismCount;
+    int firstMember;
+} NetGroup;
+
+// NET_BATCH_LANES organisms from one group, with their weights and states laid
+// out as [connection][lane] and [neuron][lane] at these byte offsets into the
+// batch's storage.
+typedef struct {
+    int group;
+    int firstMember;
+    int laneCount;
+    size_t weights;
+    size_t states;
+} NetBlock;
+
+typedef struct {
+    int capacity;
+
+    int groupCount;
+    NetGroup* groups;
+    uint64_t* groupHashes;
+    int* hashTable;
+    int hashTableSize;
+
+    // organism ids ordered by group
+    OrganismId* members;
+    int* memberGroup;
+
+    int blockCount;
+    NetBlock* blocks;
+
+    // organisms that are evaluated one at a time
+    int scalarCount;
+    OrganismId* scalar;
+
+    ActivationMode activation;
+
+    // sizes in bytes
+    void* storage;
+    size_t storageSize;
+    size_t storageCapacity;
+} NetBatch;
+
+NetBatch createNetBatch(int capacity);
+void destroyNetBatch(NetBatch* batch);
+void buildNetBatch(NetBatch* batch, OrganismStore* orgs, ActivationMode activation);
+void runNetBatch(NetBatch* batch, OrganismStore* orgs, ThreadPool* pool);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef NetCache_h
+#define NetCache_h
+
+#include "Common.h"
+#include "Arena.h"
+
+// Organisms with byte-identical genomes get identical nets, so each distinct
+// genome is built once and its connections are shared read-only by every
+// organism that has it. Only the neurons, which hold each organism's state,
+// are copied per organism. Entries are reference counted so that they outlive
+// a generation only while the next one still uses them.
+typedef struct {
+    uint64_t hash;
+    int refs;
+
+    // the next entry in the same bucket, or in the free list
+    int next;
+
+    uint8_t geneCount;
+    Gene* genes;
+
+    // neurons with their starting state, and the shared connections
+    NeuralNet net;
+
+    // one allocation holding the connections, neurons and genes
+    void* storage;
+    size_t bytes;
+} NetCacheEntry;
+
+typedef struct {
+    int capacity;
+    NetCacheEntry* entries;
+    int freeEntry;
+
+    int* buckets;
+    int bucketCount;
+
+    uint64_t lookups;
+    uint64_t hits;
+    int liveEntries;
+    size_t liveBytes;
+    size_t peakBytes;
+} NetCache;
+
+NetCache createNetCache(int capacity);
+void destroyNetCache(NetCache* cache);
+NeuralNet acquireNeuralNet(NetCache* cache, Genome* genome, Simulation* sim, Arena* arena);
+void releaseNeuralNet(NetCache* cache, NeuralNet* net);
+
+#endif
@@ -3,7 +3,24 @@
 
 #include "Common.h"
 
+// How far apart two evaluations of the same net ended up.
+typedef struct {
+    float maxOutputDifference;
+    int outputsCompared;
+    int decisionsChanged;
+} NetDivergence;
+
+// Each gene adds at most a source and a sink to the net.
+static inline int getMaxNeuronCount(int geneCount)
+{
+    return 2 * geneCount < MAX_NEURONS ? 2 * geneCount : MAX_NEURONS;
+}
+
+NeuralConnection decodeGene(Gene* gene, Simulation* sim);
 NeuralNet buildNeuralNet(Genome *genome, Simulation* sim, Neuron* neuronBuffer, NeuralConnection* connectionBuffer);
+void runNeuralNet(NeuralNet* net, ActivationMode activation);
+NetDivergence compareNeuralNet(NeuralNet* net, ActivationMode activation, ActivationMode other);
+void addNetDivergence(NetDivergence* total, NetDivergence divergence);
 void destroyNeuralNet(NeuralNet *net);
 Neuron *findNeuronById(Neuron* neurons, size_t neuronCount, uint16_t id);
 NeuralNet copyNeuralNet(NeuralNet* src, Neuron* neuronBuffer, NeuralConnection* connectionBuffer);
@@ -0,0 +1,35 @@
+#ifndef ObstacleMap_h
+#define ObstacleMap_h
+
+#include "Common.h"
+#include "TileMap.h"
+
+// Obstacle tiles are 64x64 cells, one word per row. Worlds of up to 16384
+// cells a side store every tile, which takes a bit per cell.
+#define OBSTACLE_TILE_SHIFT 6
+#define OBSTACLE_TILE_SIDE (1 << OBSTACLE_TILE_SHIFT)
+#define OBSTACLE_MAX_DENSE_TILES (256 * 256)
+
+ObstacleMap createObstacleMap(Size size);
+void destroyObstacleMap(ObstacleMap* map);
+void addRectToObstacleMap(ObstacleMap* map, Rect rect);
+bool loadObstacleMap(ObstacleMap* map, const char* filename);
+size_t countObstacleCells(ObstacleMap* map);
+
+// Positions outside the world are never blocked, matching isPosInAnyRect.
+static inline bool isPosBlocked(ObstacleMap* map, Pos pos)
+{
+    if (pos.x < 0 || pos.y < 0 || pos.x >= map->size.w || pos.y >= map->size.h) {
+        return false;
+    }
+
+    int slot = findTile(&map->tiles, pos.x >> OBSTACLE_TILE_SHIFT, pos.y >> OBSTACLE_TILE_SHIFT);
+    if (slot == -1) {
+        return false;
+    }
+
+    uint64_t row = ((uint64_t*)map->tiles.tiles)[(size_t)slot * OBSTACLE_TILE_SIDE + (pos.y & (OBSTACLE_TILE_SIDE - 1))];
+    return (row >> (pos.x & (OBSTACLE_TILE_SIDE - 1))) & 1;
+}
+
+#endif
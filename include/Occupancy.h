@@ -0,0 +1,113 @@
+#ifndef Occupancy_h
+#define Occupancy_h
+
+#include "Common.h"
+#include "TileMap.h"
+
+// Occupancy tiles are 16x16 cells.
+#define OCCUPANCY_TILE_SHIFT 4
+#define OCCUPANCY_TILE_SIDE (1 << OCCUPANCY_TILE_SHIFT)
+#define OCCUPANCY_TILE_CELLS (OCCUPANCY_TILE_SIDE * OCCUPANCY_TILE_SIDE)
+
+// A square of cells with one occupancy bit per cell in each layer and the
+// organism index of each cell, which both layers share. claims counts the
+// bits set in both layers, and the tile is released when it drops to zero.
+typedef struct {
+    uint64_t occupied[2][OCCUPANCY_TILE_CELLS / 64];
+    uint32_t claims;
+    uint32_t ids[OCCUPANCY_TILE_CELLS];
+} __attribute__((aligned(TILE_ALIGNMENT))) OccupancyTile;
+
+typedef struct {
+    int slot;
+    int cell;
+} ClaimedCell;
+
+// The cells claimed during a single step. The list lets the layer be cleared
+// without touching the whole world.
+typedef struct {
+    ClaimedCell* claimed;
+    uint32_t claimedCount;
+} OccupancyLayer;
+
+// Two alternating layers (the one being filled in this step and the finished
+// one from the step before) sharing a single organism index per cell, plus
+// one alive bit per organism. Occupancy questions only ever touch the bits.
+// Unless the population could cover the whole world, only the tiles with a
+// cell claimed in either layer are stored, so a sparse population costs
+// memory in proportion to the area it covers rather than the world's size.
+//
+// Both layers share the index array, so a cell in the previous layer that has
+// already been claimed again this step reports the new claimant. Cells like
+// that are contested regardless of who held them before.
+typedef struct {
+    int population;
+    int current;
+    OccupancyLayer layers[2];
+    TileMap tiles;
+    uint64_t* alive;
+} OccupancyGrid;
+
+typedef struct {
+    TileMap* tiles;
+    OccupancyLayer* layer;
+    int layerIndex;
+    uint64_t* alive;
+    OrganismStore* orgs;
+} OccupancyView;
+
+OccupancyGrid createOccupancyGrid(Size size, int population);
+void destroyOccupancyGrid(OccupancyGrid* grid);
+void advanceOccupancyGrid(OccupancyGrid* grid);
+OccupancyView getCurrentOccupancy(OccupancyGrid* grid, OrganismStore* orgs);
+OccupancyView getPreviousOccupancy(OccupancyGrid* grid, OrganismStore* orgs);
+size_t getOccupancyGridBytes(OccupancyGrid* grid);
+void claimCell(OccupancyView view, Pos pos, uint32_t id);
+bool claimTileCell(OccupancyView view, int slot, Pos pos, uint32_t id);
+
+static inline int getOccupancyTileCell(Pos pos)
+{
+    return ((pos.y & (OCCUPANCY_TILE_SIDE - 1)) << OCCUPANCY_TILE_SHIFT) | (pos.x & (OCCUPANCY_TILE_SIDE - 1));
+}
+
+// Returns the tile holding pos, or NULL if no cell in it is claimed.
+static inline OccupancyTile* findOccupancyTile(OccupancyView view, Pos pos)
+{
+    OccupancyTile* tiles = (OccupancyTile*)view.tiles->tiles;
+
+    if (view.tiles->dense) {
+        return &tiles[(pos.y >> OCCUPANCY_TILE_SHIFT) * view.tiles->tilesAcross + (pos.x >> OCCUPANCY_TILE_SHIFT)];
+    }
+
+    int slot = findTile(view.tiles, pos.x >> OCCUPANCY_TILE_SHIFT, pos.y >> OCCUPANCY_TILE_SHIFT);
+    return slot == -1 ? NULL : &tiles[slot];
+}
+
+static inline bool isTileCellOccupied(OccupancyView view, OccupancyTile* tile, int cell)
+{
+    return tile != NULL && (tile->occupied[view.layerIndex][cell >> 6] >> (cell & 63)) & 1;
+}
+
+static inline bool isCellOccupied(OccupancyView view, Pos pos)
+{
+    return isTileCellOccupied(view, findOccupancyTile(view, pos), getOccupancyTileCell(pos));
+}
+
+// Only meaningful for occupied cells.
+static inline uint32_t getCellOccupant(OccupancyView view, Pos pos)
+{
+    return findOccupancyTile(view, pos)->ids[getOccupancyTileCell(pos)];
+}
+
+static inline bool isOccupantAlive(OccupancyView view, uint32_t id)
+{
+    return (view.alive[id >> 6] >> (id & 63)) & 1;
+}
+
+// Organisms can die while thinking on any thread, so this is atomic.
+static inline void markOccupantDead(OccupancyView view, uint32_t id)
+{
+    __atomic_fetch_and(&view.alive[id >> 6], ~((uint64_t)1 << (id & 63)), __ATOMIC_RELAXED);
+}
+
+#endif
@@ -2,18 +2,30 @@
 #define Organism_h
 
 #include "Common.h"
+#include "Random.h"
+#include "Genome.h"
+#include "CellSampler.h"
+#include "Survivors.h"
+#include "Occupancy.h"
+#include "NetCache.h"
+#include "Arena.h"
 
-Organism makeRandomOrganism(Simulation* sim, Organism **organismsByPosition, Neuron* neuronBuffer, NeuralConnection* connectionBuffer, Gene* geneBuffer);
-Organism *getOrganismByPos(Pos pos, Simulation* sim, Organism **orgsByPosition,
+size_t getOrganismArenaBytes(Simulation* sim);
+void makeRandomOrganism(OrganismStore* orgs, OrganismId id, Simulation* sim, OccupancyView organismsByPosition, CellSampler* freeCells, NetCache* netCache, Arena* arena);
+Organism *getOrganismByPos(Pos pos, Simulation* sim, OccupancyView orgsByPosition,
                            bool aliveOnly);
 void destroyOrganism(Organism *org);
-Organism makeOffspring(Organism *a, Organism *b, Simulation* sim, Organism **orgsByPosition, Neuron* neuronBuffer, NeuralConnection* connectionBuffer, Gene* geneBuffer);
-void findMates(Organism orgs[], int population, Organism **outA,
-               Organism **outB);
-void organismRunStep(Organism *org, Organism **organismsByPosition, Organism** prevOrgsByPosition, Simulation* sim,
-                     int currentStep);
+void makeOffspring(OrganismStore* orgs, OrganismId id, Organism *a, Organism *b, Simulation* sim, OccupancyView orgsByPosition, CellSampler* freeCells, int generation, MutationSchedule* mutations, NetCache* netCache, Arena* arena);
+void findMates(Organism orgs[], SurvivorIndex* survivors, RandomStream* rng,
+               Organism **outA, Organism **outB);
+bool isPosOccupied(Pos pos, Simulation* sim, OccupancyView orgsByPosition);
+void setOrganismByPosition(Simulation* sim, OccupancyView orgsByPosition, OrganismStore* orgs, OrganismId id);
+void organismSense(OrganismStore* orgs, OrganismId id, OccupancyView prevOrgsByPosition, Simulation* sim, int currentStep);
+void organismDecide(OrganismStore* orgs, OrganismId id, OccupancyView prevOrgsByPosition, Simulation* sim, int generation, int currentStep);
+void organismThink(OrganismStore* orgs, OrganismId id, OccupancyView prevOrgsByPosition, Simulation* sim, int generation, int currentStep);
+int prepareOrganismAct(OrganismStore* orgs, OrganismId id, Simulation* sim, OccupancyView orgsByPosition, OccupancyView prevOrgsByPosition);
+void organismAct(OrganismStore* orgs, OrganismId id, OccupancyView organismsByPosition, OccupancyView prevOrgsByPosition, Simulation* sim);
 
 Organism copyOrganism(Organism *src, Neuron* neuronBuffer, NeuralConnection* connectionBuffer, Gene* geneBuffer);
-void copyOrganismMutableState(Organism* dest, Organism* src);
 
 #endif
@@ -0,0 +1,78 @@
+#ifndef OrganismStore_h
+#define OrganismStore_h
+
+#include "Common.h"
+
+OrganismStore createOrganismStore(int count);
+void destroyOrganismStore(OrganismStore* store);
+int countLivingOrganisms(OrganismStore* store);
+void copyOrganismStoreState(OrganismStore* dest, OrganismStore* src);
+
+// Access to one organism's state. Passes over the whole population, like
+// countLivingOrganisms, read the columns themselves.
+static inline Organism* getOrganism(OrganismStore* store, OrganismId id)
+{
+    return &store->orgs[id];
+}
+
+static inline bool isOrganismAlive(OrganismStore* store, OrganismId id)
+{
+    return store->alive[id];
+}
+
+static inline void setOrganismAlive(OrganismStore* store, OrganismId id, bool alive)
+{
+    store->alive[id] = alive;
+}
+
+static inline Pos getOrganismPos(OrganismStore* store, OrganismId id)
+{
+    return store->pos[id];
+}
+
+static inline void setOrganismPos(OrganismStore* store, OrganismId id, Pos pos)
+{
+    store->pos[id] = pos;
+}
+
+static inline Pos getOrganismLastPos(OrganismStore* store, OrganismId id)
+{
+    return store->lastPos[id];
+}
+
+static inline void setOrganismLastPos(OrganismStore* store, OrganismId id, Pos pos)
+{
+    store->lastPos[id] = pos;
+}
+
+static inline bool didOrganismCollide(OrganismStore* store, OrganismId id)
+{
+    return store->didCollide[id];
+}
+
+static inline void setOrganismCollided(OrganismStore* store, OrganismId id, bool didCollide)
+{
+    store->didCollide[id] = didCollide;
+}
+
+static inline float getOrganismEnergy(OrganismStore* store, OrganismId id)
+{
+    return store->energyLevel[id];
+}
+
+static inline void setOrganismEnergy(OrganismStore* store, OrganismId id, float energyLevel)
+{
+    store->energyLevel[id] = energyLevel;
+}
+
+static inline Direction getOrganismDirection(OrganismStore* store, OrganismId id)
+{
+    return store->direction[id];
+}
+
+static inline void setOrganismDirection(OrganismStore* store, OrganismId id, Direction direction)
+{
+    store->direction[id] = direction;
+}
+
+#endif
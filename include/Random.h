@@ -0,0 +1,35 @@
+#ifndef Random_h
+#define Random_h
+
+#include "Common.h"
+
+// Every random decision in the simulation draws from its own stream. A stream
+// is identified by what the decision is for and where it happens, so the same
+// decision always sees the same numbers no matter which thread makes it or in
+// what order.
+typedef enum {
+    RNG_GENOME,
+    RNG_PLACEMENT,
+    RNG_DIRECTION,
+    RNG_MATING,
+    RNG_CROSSOVER,
+    RNG_MUTATION,
+    RNG_OUTPUTS,
+    RNG_MIGRATION,
+    RNG_MAX
+} RandomPurpose;
+
+typedef struct {
+    uint32_t key[2];
+    uint32_t counter[4];
+    uint32_t buffer[4];
+    uint8_t buffered;
+} RandomStream;
+
+RandomStream makeRandomStream(int seed, int generation, int step, OrganismId id, RandomPurpose purpose);
+uint32_t randomUint32(RandomStream* rng);
+uint32_t randomBelow(RandomStream* rng, uint32_t n);
+float randomFloat(RandomStream* rng);
+void randomFill(RandomStream* rng, uint32_t* out, size_t count);
+
+#endif
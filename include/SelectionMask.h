@@ -0,0 +1,16 @@
+#ifndef SelectionMask_h
+#define SelectionMask_h
+
+#include "Common.h"
+
+// Worlds with more cells than this have no selection mask. At the limit the
+// mask takes 8 MB.
+#define SELECTION_MASK_MAX_CELLS (1 << 26)
+
+SelectionMask createSelectionMask(Simulation* sim);
+bool loadSelectionMask(SelectionMask* mask, const char* filename);
+void destroySelectionMask(SelectionMask* mask);
+size_t getSelectionMaskBytes(SelectionMask* mask);
+void selectOrganisms(Simulation* sim, Pos* pos, bool* alive, int count, bool* selected);
+
+#endif
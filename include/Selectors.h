@@ -24,9 +24,9 @@ extern SelectionCriteria farLeftOrRightSelector;
 extern SelectionCriteria hollowCircleSelector;
 extern SelectionCriteria donutSelector;
 
-// bool farLeftSelector(Organism *org, Simulation *sim);
-// bool farRightSelector(Organism *org, Simulation *sim);
+// bool farLeftSelector(Pos pos, Simulation *sim);
+// bool farRightSelector(Pos pos, Simulation *sim);
 
-// bool farLeftAndRightSelector(Organism *org, Simulation *sim);
+// bool farLeftAndRightSelector(Pos pos, Simulation *sim);
 
 #endif
@@ -0,0 +1,27 @@
+#ifndef SensorField_h
+#define SensorField_h
+
+#include "Common.h"
+
+// Worlds with more cells than this compute position sensors on every read
+// instead of keeping a table.
+#define SENSOR_FIELD_MAX_CELLS (1 << 22)
+
+SensorField createSensorField(Size size);
+void destroySensorField(SensorField* field);
+size_t getSensorFieldBytes(SensorField* field);
+float computePositionSensor(Size size, InputType input, Pos pos);
+
+// The level of a position sensor at pos, which must be inside the world.
+// Inputs that are not tabulated are computed on the spot.
+static inline float readSensorField(SensorField* field, InputType input, Pos pos)
+{
+    if (field->values == NULL || field->slots[input] == -1) {
+        return computePositionSensor(field->size, input, pos);
+    }
+
+    uint32_t cell = (uint32_t)pos.y * field->size.w + pos.x;
+    return field->values[cell * field->sensorCount + field->slots[input]];
+}
+
+#endif
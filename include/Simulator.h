@@ -3,7 +3,7 @@
 
 #include "Common.h"
 
-void runSimulation(Simulation*);
+int runSimulation(Simulation*);
 void simSendReady(void);
 void simSendQuit(void);
 
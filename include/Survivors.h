@@ -0,0 +1,29 @@
+#ifndef Survivors_h
+#define Survivors_h
+
+#include "Common.h"
+#include "Random.h"
+
+// A compact list of the organisms that survived selection, so that parents can
+// be drawn in constant time no matter how few organisms survived.
+typedef struct {
+    int count;
+    int capacity;
+    OrganismId* ids;
+    float* fitness;
+
+    // Walker/Vose alias table over ids, only built for MATING_FITNESS
+    bool weighted;
+    float* probability;
+    int* alias;
+    int* worklist;
+} SurvivorIndex;
+
+SurvivorIndex createSurvivorIndex(int capacity);
+void destroySurvivorIndex(SurvivorIndex* index);
+void clearSurvivorIndex(SurvivorIndex* index);
+void addSurvivor(SurvivorIndex* index, OrganismId id, float fitness);
+void buildSurvivorIndex(SurvivorIndex* index, MatingMode mode);
+int sampleSurvivor(SurvivorIndex* index, RandomStream* rng);
+
+#endif
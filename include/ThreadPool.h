@@ -0,0 +1,16 @@
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include "Common.h"
+
+// Processes the half-open range [start, end) of a parallel loop.
+typedef void (*ThreadPoolFn)(void* ctx, int start, int end);
+
+typedef struct ThreadPool_t ThreadPool;
+
+ThreadPool* createThreadPool(int threadCount);
+void destroyThreadPool(ThreadPool* pool);
+int getThreadPoolSize(ThreadPool* pool);
+void threadPoolParallelFor(ThreadPool* pool, int count, ThreadPoolFn fn, void* ctx);
+
+#endif
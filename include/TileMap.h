@@ -0,0 +1,69 @@
+#ifndef TileMap_h
+#define TileMap_h
+
+#include "Common.h"
+
+// Tiles start on a cache line, and a tile's size must be a multiple of it.
+#define TILE_ALIGNMENT 64
+
+// The key of a slot that has been released.
+#define TILE_KEY_FREE UINT64_MAX
+
+TileMap createTileMap(size_t tileBytes, Size tiles, int maxDenseTiles);
+void destroyTileMap(TileMap* map);
+int addTile(TileMap* map, int32_t tileX, int32_t tileY);
+void releaseTile(TileMap* map, int slot);
+size_t getTileMapBytes(TileMap* map);
+
+// How many tiles of 2^shift cells a side cover a world of the given size.
+static inline Size getTileGridSize(Size size, int shift)
+{
+    return (Size) {
+        .w = (int32_t)(((int64_t)size.w + (1 << shift) - 1) >> shift),
+        .h = (int32_t)(((int64_t)size.h + (1 << shift) - 1) >> shift),
+    };
+}
+
+// Tile coordinates are never negative, so no key is TILE_KEY_FREE.
+static inline uint64_t getTileKey(int32_t tileX, int32_t tileY)
+{
+    return ((uint64_t)(uint32_t)tileY << 32) | (uint32_t)tileX;
+}
+
+// Fibonacci hashing: the top bits of the key times 2^64 / phi.
+static inline uint32_t getTileBucket(TileMap* map, uint64_t key)
+{
+    return (uint32_t)((key * 0x9e3779b97f4a7c15ull) >> map->bucketShift);
+}
+
+// Returns the slot of the tile, or -1 if it isn't stored. The tile must be
+// inside the world.
+static inline int findTile(TileMap* map, int32_t tileX, int32_t tileY)
+{
+    if (map->dense) {
+        return tileY * map->tilesAcross + tileX;
+    }
+
+    uint64_t key = getTileKey(tileX, tileY);
+    uint32_t mask = map->bucketCount - 1;
+
+    for (uint32_t b = getTileBucket(map, key);; b = (b + 1) & mask) {
+        TileBucket bucket = map->buckets[b];
+        if (bucket.slot == -1 || bucket.key == key) {
+            return bucket.slot;
+        }
+    }
+}
+
+// Adding a tile can move every tile, so the pointer is only good until then.
+static inline void* getTile(TileMap* map, int slot)
+{
+    return map->tiles + (size_t)slot * map->tileBytes;
+}
+
+static inline bool isTileInUse(TileMap* map, int slot)
+{
+    return map->dense || map->tileKeys[slot] != TILE_KEY_FREE;
+}
+
+#endif
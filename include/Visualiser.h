@@ -5,8 +5,8 @@
 #include <SDL2/SDL.h>
 #include "Common.h"
 
-void visSendGeneration(Organism* orgs, int generation);
-void visSendStep(Organism* orgs, int step);
+void visSendGeneration(OrganismStore* orgs, int generation);
+void visSendStep(OrganismStore* orgs, int step);
 void visSendQuit(void);
 void visSendReady(void);
 void visSendDisconnected(void);
@@ -0,0 +1,102 @@
+// Every activation must give the same result whether it runs on its own or in
+// a vector lane. Multiplies and adds must not be fused into FMAs in the wider
+// clones, and -Ofast must not turn the divisions into (approximate)
+// reciprocals, which it only does in vector code.
+#pragma GCC optimize ("fp-contract=off", "no-unsafe-math-optimizations")
+
+#include "Activation.h"
+
+#include <math.h>
+#include <string.h>
+
+static const char* activationNames[] = {
+    [ACTIVATION_EXACT] = "exact",
+    [ACTIVATION_FAST] = "fast",
+};
+
+// tanh is within half an ulp of +-1 beyond this.
+#define FAST_TANH_CLAMP 7.90531110763549805f
+
+// An odd rational approximation of tanh, a degree 13 polynomial over a degree
+// 6 one, fitted on [-FAST_TANH_CLAMP, FAST_TANH_CLAMP]. It only uses adds,
+// multiplies and a divide, so it vectorises wherever it is inlined.
+static inline float fastTanhKernel(float x)
+{
+    x = x < -FAST_TANH_CLAMP ? -FAST_TANH_CLAMP : x;
+    x = x > FAST_TANH_CLAMP ? FAST_TANH_CLAMP : x;
+
+    float x2 = x * x;
+
+    float p = -2.76076847742355e-16f;
+    p = p * x2 + 2.00018790482477e-13f;
+    p = p * x2 + -8.60467152213735e-11f;
+    p = p * x2 + 5.12229709037114e-08f;
+    p = p * x2 + 1.48572235717979e-05f;
+    p = p * x2 + 6.37261928875436e-04f;
+    p = p * x2 + 4.89352455891786e-03f;
+    p = p * x;
+
+    float q = 1.19825839466702e-06f;
+    q = q * x2 + 1.18534705686654e-04f;
+    q = q * x2 + 2.26843463243900e-03f;
+    q = q * x2 + 4.89352518554385e-03f;
+
+    return p / q;
+}
+
+float fastTanhf(float x)
+{
+    return fastTanhKernel(x);
+}
+
+bool parseActivation(const char* name, ActivationMode* activation)
+{
+    for (size_t i = 0; i < sizeof(activationNames) / sizeof(activationNames[0]); i++) {
+        if (strcmp(name, activationNames[i]) == 0) {
+            *activation = (ActivationMode)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* getActivationName(ActivationMode activation)
+{
+    return activationNames[activation];
+}
+
+float activate(float x, ActivationMode activation)
+{
+    return activation == ACTIVATION_FAST ? fastTanhKernel(x) : tanhf(x);
+}
+
+// glibc's vector tanhf, which -Ofast would call for this loop, rounds
+// differently from tanhf, so the exact activation is applied one value at a
+// time.
+__attribute__((optimize("no-tree-vectorize")))
+static void activateLanesExact(float* x, int count, float divisor)
+{
+    for (int i = 0; i < count; i++) {
+        x[i] = tanhf(x[i] / divisor);
+    }
+}
+
+__attribute__((target_clones("avx512f", "avx2", "default")))
+static void activateLanesFast(float* x, int count, float divisor)
+{
+    for (int i = 0; i < count; i++) {
+        x[i] = fastTanhKernel(x[i] / divisor);
+    }
+}
+
+// Divides each of the count values by divisor and applies the activation,
+// giving exactly what activate would for each value on its own.
+void activateLanes(float* x, int count, float divisor, ActivationMode activation)
+{
+    if (activation == ACTIVATION_FAST) {
+        activateLanesFast(x, count, divisor);
+    } else {
+        activateLanesExact(x, count, divisor);
+    }
+}
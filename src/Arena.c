@@ -0,0 +1,49 @@
+#include "Arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+Arena createArena(size_t capacity)
+{
+    capacity = getArenaAllocationBytes(capacity);
+
+    return (Arena) {
+        .base = aligned_alloc(ARENA_ALIGNMENT, capacity > 0 ? capacity : ARENA_ALIGNMENT),
+        .capacity = capacity,
+        .used = 0,
+        .peak = 0,
+    };
+}
+
+void destroyArena(Arena* arena)
+{
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+void resetArena(Arena* arena)
+{
+    arena->used = 0;
+}
+
+// Arenas are sized for the worst case up front, so running out means that
+// bound was wrong.
+void* arenaAlloc(Arena* arena, size_t bytes)
+{
+    bytes = getArenaAllocationBytes(bytes);
+
+    if (arena->used + bytes > arena->capacity) {
+        fprintf(stderr, "Arena of %zu bytes cannot fit another %zu bytes!\n", arena->capacity, bytes);
+        exit(1);
+    }
+
+    void* block = arena->base + arena->used;
+    arena->used += bytes;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+
+    return block;
+}
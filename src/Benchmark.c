@@ -0,0 +1,660 @@
+#include "Benchmark.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "Activation.h"
+#include "Islands.h"
+#include "Genome.h"
+#include "NeuralNet.h"
+#include "NetBatch.h"
+#include "ObstacleMap.h"
+#include "OrganismStore.h"
+#include "Random.h"
+#include "SensorField.h"
+#include "SelectionMask.h"
+#include "Simulator.h"
+#include "ThreadPool.h"
+
+#define BENCH_ORGANISMS 4096
+#define BENCH_STEPS 64
+#define BENCH_INTERNAL_NEURONS 4
+
+#define ACTIVATION_SWEEP_LIMIT 10.0f
+#define ACTIVATION_SWEEP_STRIDE 61
+#define ACTIVATION_BENCH_VALUES 4096
+#define ACTIVATION_BENCH_ROUNDS 4096
+
+// Populations grow by 4x from 1,000 to 4,096,000 and the world by 2x a side
+// from 128x128, which keeps the default density.
+#define POPULATION_BENCH_START 1000
+#define POPULATION_BENCH_SIZES 7
+#define POPULATION_BENCH_SIDE 128
+#define POPULATION_BENCH_GENERATIONS 2
+#define POPULATION_BENCH_STEPS 20
+
+// The default world is filled to each of these percentages of its cells.
+#define COLLISION_BENCH_GENERATIONS 2
+#define COLLISION_BENCH_STEPS 200
+static const int collisionBenchDensities[] = { 10, 30, 50, 70, 80, 90 };
+
+// Islands double up to at least this many, and one thread is given to each.
+#define ISLAND_BENCH_MAX_ISLANDS 8
+#define ISLAND_BENCH_GENERATIONS 10
+#define ISLAND_BENCH_STEPS 100
+
+// Genomes of each length are copied, crossed over and mutated across a
+// population large enough that the genes do not fit in cache.
+#define GENOME_BENCH_ORGANISMS 65536
+#define GENOME_BENCH_ROUNDS 8
+
+// nets are only built for up to MAX_CONNECTIONS genes
+static const int benchGeneCounts[] = { 2, 16, 128 };
+static const int genomeBenchGeneCounts[] = { 2, 16, 128, UINT8_MAX };
+
+typedef struct {
+    int geneCount;
+    Simulation sim;
+    Gene* genes;
+    Neuron* neurons;
+    NeuralConnection* connections;
+    NeuralNet* nets;
+
+    // the connections of each net in gene order, for the reference evaluator
+    NeuralConnection* geneConnections;
+
+    // the same nets with their own neuron states, for the batched evaluator
+    Neuron* batchNeurons;
+    OrganismStore orgs;
+    NetBatch batch;
+} NetBench;
+
+static uint64_t nowInNanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// The original evaluator: sweeps over the connections in gene order, looking
+// neurons up by id, until no more connections can fire.
+static void runNeuralNetReference(NeuralNet* net, NeuralConnection* connections)
+{
+    bool visited[MAX_CONNECTIONS] = { false };
+    uint8_t inputsVisited[MAX_NEURONS] = { 0 };
+    int visits;
+
+    do {
+        visits = 0;
+
+        for (int i = 0; i < net->connectionCount; i++) {
+            NeuralConnection *connection = &connections[i];
+
+            if (visited[i]) {
+                continue;
+            }
+
+            Neuron *source = findNeuronById(net->neurons, net->neuronCount, connection->sourceId);
+            if (source->inputs && (inputsVisited[source - net->neurons] < source->inputs)) {
+                continue;
+            }
+
+            Neuron *sink = findNeuronById(net->neurons, net->neuronCount, connection->sinkId);
+
+            if (sink == source) {
+                sink->state += connection->weight * source->prevState;
+            } else {
+                sink->state += connection->weight * source->state;
+            }
+
+            inputsVisited[sink - net->neurons]++;
+            visited[i] = true;
+
+            if (inputsVisited[sink - net->neurons] == sink->inputs) {
+                sink->state = tanhf(sink->state / (float)sink->inputs);
+            }
+
+            visits++;
+        }
+    } while (visits > 0);
+}
+
+static NetBench createNetBench(Simulation* sim, int geneCount)
+{
+    NetBench bench = {
+        .geneCount = geneCount,
+        .sim = *sim,
+        .genes = calloc(BENCH_ORGANISMS * geneCount, sizeof(Gene)),
+        .neurons = calloc(BENCH_ORGANISMS * MAX_NEURONS, sizeof(Neuron)),
+        .connections = calloc(BENCH_ORGANISMS * MAX_CONNECTIONS, sizeof(NeuralConnection)),
+        .nets = calloc(BENCH_ORGANISMS, sizeof(NeuralNet)),
+        .geneConnections = calloc(BENCH_ORGANISMS * MAX_CONNECTIONS, sizeof(NeuralConnection)),
+        .batchNeurons = calloc(BENCH_ORGANISMS * MAX_NEURONS, sizeof(Neuron)),
+        .orgs = createOrganismStore(BENCH_ORGANISMS),
+        .batch = createNetBatch(BENCH_ORGANISMS),
+    };
+
+    bench.sim.numberOfGenes = geneCount;
+    bench.sim.maxInternalNeurons = BENCH_INTERNAL_NEURONS;
+
+    for (int i = 0; i < BENCH_ORGANISMS; i++) {
+        RandomStream rng = makeRandomStream(sim->seed, 0, geneCount, i, RNG_GENOME);
+        Genome genome = makeRandomGenome(geneCount, &bench.genes[i * geneCount], &rng);
+
+        bench.nets[i] = buildNeuralNet(&genome, &bench.sim, &bench.neurons[i * MAX_NEURONS], &bench.connections[i * MAX_CONNECTIONS]);
+
+        for (int g = 0; g < geneCount; g++) {
+            bench.geneConnections[i * MAX_CONNECTIONS + g] = decodeGene(&genome.genes[g], &bench.sim);
+        }
+
+        Organism* org = getOrganism(&bench.orgs, i);
+        org->id = i;
+        org->net = bench.nets[i];
+        org->net.neurons = &bench.batchNeurons[i * MAX_NEURONS];
+        memcpy(org->net.neurons, bench.nets[i].neurons, bench.nets[i].neuronCount * sizeof(Neuron));
+        setOrganismAlive(&bench.orgs, i, true);
+    }
+
+    return bench;
+}
+
+static void destroyNetBench(NetBench* bench)
+{
+    free(bench->genes);
+    free(bench->neurons);
+    free(bench->connections);
+    free(bench->nets);
+    free(bench->geneConnections);
+    free(bench->batchNeurons);
+    destroyOrganismStore(&bench->orgs);
+    destroyNetBatch(&bench->batch);
+}
+
+// Starts a step the same way organismThink does, with made up input levels.
+static void startBenchStep(NeuralNet* net, int organism, int step)
+{
+    for (int n = 0; n < net->neuronCount; n++) {
+        Neuron* neuron = &net->neurons[n];
+        neuron->prevState = neuron->state;
+        neuron->state = 0.0f;
+
+        if (neuron->type == NEURON_INPUT) {
+            uint32_t h = (uint32_t)(organism * 2654435761u) ^ (uint32_t)(step * 40503u) ^ neuron->id;
+            neuron->state = (float)(h % 2001) / 1000.0f - 1.0f;
+        }
+    }
+}
+
+static uint64_t timeNetBench(NetBench* bench, bool reference, ActivationMode activation)
+{
+    uint64_t start = nowInNanoseconds();
+
+    for (int step = 0; step < BENCH_STEPS; step++) {
+        for (int i = 0; i < BENCH_ORGANISMS; i++) {
+            startBenchStep(&bench->nets[i], i, step);
+            if (reference) {
+                runNeuralNetReference(&bench->nets[i], &bench->geneConnections[i * MAX_CONNECTIONS]);
+            } else {
+                runNeuralNet(&bench->nets[i], activation);
+            }
+        }
+    }
+
+    return nowInNanoseconds() - start;
+}
+
+static uint64_t timeNetBatchBench(NetBench* bench, ActivationMode activation, ThreadPool* pool)
+{
+    buildNetBatch(&bench->batch, &bench->orgs, activation);
+
+    uint64_t start = nowInNanoseconds();
+
+    for (int step = 0; step < BENCH_STEPS; step++) {
+        for (int i = 0; i < BENCH_ORGANISMS; i++) {
+            startBenchStep(&getOrganism(&bench->orgs, i)->net, i, step);
+        }
+        runNetBatch(&bench->batch, &bench->orgs, pool);
+    }
+
+    return nowInNanoseconds() - start;
+}
+
+// Counts the output neurons whose state differs between the two evaluators
+// over a full run, comparing bit for bit.
+static int countNetMismatches(NetBench* bench, int* outputsChecked)
+{
+    int mismatches = 0;
+    Neuron reference[MAX_NEURONS];
+
+    *outputsChecked = 0;
+
+    for (int i = 0; i < BENCH_ORGANISMS; i++) {
+        NeuralNet* net = &bench->nets[i];
+        NeuralNet referenceNet = *net;
+        referenceNet.neurons = reference;
+        memcpy(reference, net->neurons, net->neuronCount * sizeof(Neuron));
+
+        for (int step = 0; step < BENCH_STEPS; step++) {
+            startBenchStep(net, i, step);
+            runNeuralNet(net, ACTIVATION_EXACT);
+
+            startBenchStep(&referenceNet, i, step);
+            runNeuralNetReference(&referenceNet, &bench->geneConnections[i * MAX_CONNECTIONS]);
+
+            for (int n = 0; n < net->neuronCount; n++) {
+                if (net->neurons[n].type != NEURON_OUTPUT) continue;
+
+                (*outputsChecked)++;
+                if (memcmp(&net->neurons[n].state, &reference[n].state, sizeof(float)) != 0) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    return mismatches;
+}
+
+// Counts the output neurons whose state differs between the batched and the
+// compiled evaluator over a full run, comparing bit for bit.
+static int countBatchMismatches(NetBench* bench, ActivationMode activation, ThreadPool* pool)
+{
+    int mismatches = 0;
+
+    buildNetBatch(&bench->batch, &bench->orgs, activation);
+
+    for (int step = 0; step < BENCH_STEPS; step++) {
+        for (int i = 0; i < BENCH_ORGANISMS; i++) {
+            startBenchStep(&bench->nets[i], i, step);
+            runNeuralNet(&bench->nets[i], activation);
+            startBenchStep(&getOrganism(&bench->orgs, i)->net, i, step);
+        }
+        runNetBatch(&bench->batch, &bench->orgs, pool);
+
+        for (int i = 0; i < BENCH_ORGANISMS; i++) {
+            NeuralNet* net = &bench->nets[i];
+            for (int n = 0; n < net->neuronCount; n++) {
+                if (net->neurons[n].type != NEURON_OUTPUT) continue;
+
+                if (memcmp(&net->neurons[n].state, &getOrganism(&bench->orgs, i)->net.neurons[n].state, sizeof(float)) != 0) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    return mismatches;
+}
+
+// Measures the largest difference between fastTanhf and tanhf on every
+// ACTIVATION_SWEEP_STRIDE-th float between -ACTIVATION_SWEEP_LIMIT and
+// ACTIVATION_SWEEP_LIMIT, which covers everywhere they can differ.
+static float measureFastTanhError(void)
+{
+    float maxError = 0.0f;
+
+    for (float x = -ACTIVATION_SWEEP_LIMIT; x <= ACTIVATION_SWEEP_LIMIT;) {
+        float error = fabsf(fastTanhf(x) - tanhf(x));
+        if (error > maxError) {
+            maxError = error;
+        }
+
+        for (int i = 0; i < ACTIVATION_SWEEP_STRIDE; i++) {
+            x = nextafterf(x, INFINITY);
+        }
+    }
+
+    return maxError;
+}
+
+static uint64_t timeActivation(float* values, ActivationMode activation, bool lanes)
+{
+    uint64_t start = nowInNanoseconds();
+
+    for (int r = 0; r < ACTIVATION_BENCH_ROUNDS; r++) {
+        if (lanes) {
+            activateLanes(values, ACTIVATION_BENCH_VALUES, 1.0f, activation);
+        } else {
+            for (int i = 0; i < ACTIVATION_BENCH_VALUES; i++) {
+                values[i] = activate(values[i], activation);
+            }
+        }
+    }
+
+    return nowInNanoseconds() - start;
+}
+
+// Checks that fastTanhf stays within FAST_TANH_MAX_ERROR of tanhf and times
+// both activations one value at a time and in lanes.
+static bool runActivationBenchmark(void)
+{
+    float maxError = measureFastTanhError();
+    bool withinBound = maxError <= FAST_TANH_MAX_ERROR;
+
+    printf("Activation, fastTanhf differs from tanhf by at most %.3g (bound %.3g)\n",
+           maxError, FAST_TANH_MAX_ERROR);
+    printf("%6s %16s %16s\n", "", "exact ns/value", "fast ns/value");
+
+    float* values = malloc(ACTIVATION_BENCH_VALUES * sizeof(float));
+    double evaluations = (double)ACTIVATION_BENCH_ROUNDS * ACTIVATION_BENCH_VALUES;
+
+    for (int lanes = 0; lanes <= 1; lanes++) {
+        uint64_t times[2];
+
+        for (int activation = ACTIVATION_EXACT; activation <= ACTIVATION_FAST; activation++) {
+            for (int i = 0; i < ACTIVATION_BENCH_VALUES; i++) {
+                values[i] = (float)(i % 2001) / 250.0f - 4.0f;
+            }
+            times[activation] = timeActivation(values, activation, lanes);
+        }
+
+        printf("%6s %16.2f %16.2f\n", lanes ? "lanes" : "scalar",
+               times[ACTIVATION_EXACT] / evaluations, times[ACTIVATION_FAST] / evaluations);
+    }
+
+    free(values);
+
+    return withinBound;
+}
+
+// Compares the compiled network evaluator against the original one on random
+// genomes of several sizes, checking that they agree and timing both. The
+// batched evaluator is checked against the compiled one with both
+// activations, and is timed on a single thread with the fast activation so
+// the columns compare.
+int runNetBenchmark(Simulation* sim)
+{
+    bool allMatch = runActivationBenchmark();
+    ThreadPool* pool = createThreadPool(1);
+
+    printf("\nNetwork evaluation, %d nets x %d steps, %d internal neurons\n",
+           BENCH_ORGANISMS, BENCH_STEPS, BENCH_INTERNAL_NEURONS);
+    printf("%6s %16s %16s %16s %16s %12s %10s %10s\n", "genes", "original ns/net", "compiled ns/net",
+           "fast tanh ns/net", "batched ns/net", "mismatches", "in blocks", "evaluated");
+
+    for (size_t g = 0; g < sizeof(benchGeneCounts) / sizeof(benchGeneCounts[0]); g++) {
+        NetBench bench = createNetBench(sim, benchGeneCounts[g]);
+
+        int outputsChecked;
+        int mismatches = countNetMismatches(&bench, &outputsChecked);
+        mismatches += countBatchMismatches(&bench, ACTIVATION_EXACT, pool);
+        mismatches += countBatchMismatches(&bench, ACTIVATION_FAST, pool);
+        allMatch = allMatch && mismatches == 0;
+
+        uint64_t referenceTime = timeNetBench(&bench, true, ACTIVATION_EXACT);
+        uint64_t compiledTime = timeNetBench(&bench, false, ACTIVATION_EXACT);
+        uint64_t fastTime = timeNetBench(&bench, false, ACTIVATION_FAST);
+        uint64_t batchedTime = timeNetBatchBench(&bench, ACTIVATION_FAST, pool);
+        double evaluations = (double)BENCH_ORGANISMS * BENCH_STEPS;
+
+        int inBlocks = 0;
+        for (int b = 0; b < bench.batch.blockCount; b++) {
+            inBlocks += bench.batch.blocks[b].laneCount;
+        }
+
+        // the share of connections left after pruning
+        int evaluated = 0;
+        for (int i = 0; i < BENCH_ORGANISMS; i++) {
+            evaluated += bench.nets[i].activeConnectionCount;
+        }
+
+        printf("%6d %16.1f %16.1f %16.1f %16.1f %5d/%d %9.1f%% %9.1f%%\n", bench.geneCount,
+               referenceTime / evaluations, compiledTime / evaluations, fastTime / evaluations,
+               batchedTime / evaluations, mismatches, 3 * outputsChecked,
+               inBlocks * 100.0 / BENCH_ORGANISMS, evaluated * 100.0 / (BENCH_ORGANISMS * bench.geneCount));
+
+        destroyNetBench(&bench);
+    }
+
+    destroyThreadPool(pool);
+
+    return allMatch ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Copies, crosses over and mutates a population of random genomes and reports
+// the time per genome and the gene bytes read and written per second. Every
+// kind of mutation is given the simulation's bit flip rate.
+int runGenomeBenchmark(Simulation* sim)
+{
+    float rate = sim->mutationRates.bitFlip;
+    MutationRates rates = { .bitFlip = rate, .weightPerturbation = rate, .duplication = rate };
+
+    printf("Genomes, %d organisms x %d rounds, mutation rate %g per gene\n", GENOME_BENCH_ORGANISMS,
+           GENOME_BENCH_ROUNDS, 3 * rate);
+    printf("%6s %14s %10s %14s %10s %14s %12s\n", "genes", "copy ns/gen.", "GB/s", "cross ns/gen.", "GB/s",
+           "mutate ns/gen.", "mutations");
+
+    for (size_t g = 0; g < sizeof(genomeBenchGeneCounts) / sizeof(genomeBenchGeneCounts[0]); g++) {
+        int geneCount = genomeBenchGeneCounts[g];
+        size_t genomeBytes = geneCount * sizeof(Gene);
+        Gene* parentGenes = malloc(GENOME_BENCH_ORGANISMS * genomeBytes);
+        Gene* childGenes = malloc(GENOME_BENCH_ORGANISMS * genomeBytes);
+        Genome* parents = malloc(GENOME_BENCH_ORGANISMS * sizeof(Genome));
+        Genome* children = malloc(GENOME_BENCH_ORGANISMS * sizeof(Genome));
+
+        // touched up front so that the first round does not pay for page faults
+        memset(childGenes, 0, GENOME_BENCH_ORGANISMS * genomeBytes);
+
+        for (int i = 0; i < GENOME_BENCH_ORGANISMS; i++) {
+            RandomStream rng = makeRandomStream(sim->seed, 0, 0, i, RNG_GENOME);
+            parents[i] = makeRandomGenome(geneCount, &parentGenes[i * geneCount], &rng);
+        }
+
+        uint64_t copyNanoseconds = 0, crossoverNanoseconds = 0, mutationNanoseconds = 0;
+        uint64_t mutationCount = 0;
+
+        for (int round = 0; round < GENOME_BENCH_ROUNDS; round++) {
+            uint64_t start = nowInNanoseconds();
+            for (int i = 0; i < GENOME_BENCH_ORGANISMS; i++) {
+                children[i] = copyGenome(&parents[i], &childGenes[i * geneCount]);
+            }
+
+            uint64_t copied = nowInNanoseconds();
+            for (int i = 0; i < GENOME_BENCH_ORGANISMS; i++) {
+                RandomStream rng = makeRandomStream(sim->seed, round, 0, i, RNG_CROSSOVER);
+                children[i] = reproduce(&parents[i], &parents[(i + 1) % GENOME_BENCH_ORGANISMS],
+                                        &childGenes[i * geneCount], &rng);
+            }
+
+            uint64_t crossed = nowInNanoseconds();
+            MutationSchedule mutations = createMutationSchedule(rates,
+                                         makeRandomStream(sim->seed, round, 0, 0, RNG_MUTATION));
+            for (int i = 0; i < GENOME_BENCH_ORGANISMS; i++) {
+                children[i] = mutateGenome(children[i], &mutations, NULL);
+            }
+
+            uint64_t mutated = nowInNanoseconds();
+            copyNanoseconds += copied - start;
+            crossoverNanoseconds += crossed - copied;
+            mutationNanoseconds += mutated - crossed;
+            mutationCount += mutations.mutations;
+        }
+
+        double genomes = (double)GENOME_BENCH_ORGANISMS * GENOME_BENCH_ROUNDS;
+
+        // a copy reads one genome and writes one, a crossover reads two
+        printf("%6d %14.1f %10.2f %14.1f %10.2f %14.1f %12.3f\n", geneCount,
+               copyNanoseconds / genomes, 2 * genomes * genomeBytes / copyNanoseconds,
+               crossoverNanoseconds / genomes, 3 * genomes * genomeBytes / crossoverNanoseconds,
+               mutationNanoseconds / genomes, mutationCount / genomes);
+
+        free(parentGenes);
+        free(childGenes);
+        free(parents);
+        free(children);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// The largest resident set the process has had so far. Each population is
+// larger than the last, so after a run this is that run's peak.
+static size_t getPeakResidentBytes(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (size_t)usage.ru_maxrss * 1024;
+}
+
+// Runs a few short generations at growing populations and reports how the
+// time per organism step, the time per generation and the peak memory per
+// organism scale. All three should stay roughly flat per organism.
+int runPopulationBenchmark(Simulation* sim)
+{
+    printf("Population scaling, %d generations x %d steps, %d thread(s)\n",
+           POPULATION_BENCH_GENERATIONS, POPULATION_BENCH_STEPS, sim->threads);
+    printf("%10s %12s %14s %12s %8s %14s %12s %12s\n", "organisms", "world", "ns/org-step",
+           "ms/step", "act", "ms/generation", "peak MB", "bytes/org");
+
+    for (int p = 0; p < POPULATION_BENCH_SIZES; p++) {
+        Simulation run = *sim;
+        SimulationTimings timings = { 0 };
+
+        run.population = POPULATION_BENCH_START << (2 * p);
+        run.size = (Size) {
+            .w = POPULATION_BENCH_SIDE << p, .h = POPULATION_BENCH_SIDE << p
+        };
+        run.maxGenerations = POPULATION_BENCH_GENERATIONS;
+        run.stepsPerGeneration = POPULATION_BENCH_STEPS;
+        run.headless = true;
+        run.compareActivation = false;
+        run.quiet = true;
+        run.timings = &timings;
+        run.obstacleMap = createObstacleMap(run.size);
+        run.sensorField = createSensorField(run.size);
+        run.selectionMask = createSelectionMask(&run);
+
+        runSimulation(&run);
+
+        destroyObstacleMap(&run.obstacleMap);
+        destroySensorField(&run.sensorField);
+        destroySelectionMask(&run.selectionMask);
+
+        int steps = timings.steps ? timings.steps : 1;
+        int generations = timings.generations ? timings.generations : 1;
+        size_t peakBytes = getPeakResidentBytes();
+
+        // act is the share of step time spent settling organisms into cells
+        printf("%10d %6dx%-5d %14.1f %12.3f %7.1f%% %14.1f %12.1f %12.0f\n", run.population, run.size.w,
+               run.size.h, (double)timings.stepNanoseconds / ((double)steps * run.population),
+               timings.stepNanoseconds / 1e6 / steps,
+               timings.stepNanoseconds > 0 ? 100.0 * timings.actNanoseconds / timings.stepNanoseconds : 0.0,
+               timings.generationNanoseconds / 1e6 / generations, peakBytes / 1048576.0,
+               (double)peakBytes / run.population);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int compareNanoseconds(const void* a, const void* b)
+{
+    uint64_t x = *(uint64_t*)a, y = *(uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Runs the default world at growing densities and reports the spread of step
+// times. With collisions resolved in bounded time the 99th percentile should
+// stay close to the median as the world fills up.
+int runCollisionBenchmark(Simulation* sim)
+{
+    int sampleCapacity = COLLISION_BENCH_GENERATIONS * COLLISION_BENCH_STEPS;
+    uint64_t* samples = malloc(sampleCapacity * sizeof(uint64_t));
+
+    printf("Collisions, %dx%d world, %d generations x %d steps, %d thread(s)\n", sim->size.w, sim->size.h,
+           COLLISION_BENCH_GENERATIONS, COLLISION_BENCH_STEPS, sim->threads);
+    printf("%8s %10s %12s %12s %12s %12s\n", "density", "organisms", "mean ms", "p50 ms", "p99 ms", "max ms");
+
+    for (size_t d = 0; d < sizeof(collisionBenchDensities) / sizeof(collisionBenchDensities[0]); d++) {
+        Simulation run = *sim;
+        SimulationTimings timings = {
+            .stepSamples = samples,
+            .stepSampleCapacity = sampleCapacity,
+        };
+
+        run.population = (int)((int64_t)run.size.w * run.size.h * collisionBenchDensities[d] / 100);
+        run.maxGenerations = COLLISION_BENCH_GENERATIONS;
+        run.stepsPerGeneration = COLLISION_BENCH_STEPS;
+        run.headless = true;
+        run.compareActivation = false;
+        run.quiet = true;
+        run.timings = &timings;
+        run.obstacleMap = createObstacleMap(run.size);
+        run.sensorField = createSensorField(run.size);
+        run.selectionMask = createSelectionMask(&run);
+
+        runSimulation(&run);
+
+        destroyObstacleMap(&run.obstacleMap);
+        destroySensorField(&run.sensorField);
+        destroySelectionMask(&run.selectionMask);
+
+        int count = timings.steps < sampleCapacity ? timings.steps : sampleCapacity;
+        if (count == 0) continue;
+
+        qsort(samples, count, sizeof(uint64_t), compareNanoseconds);
+
+        printf("%7d%% %10d %12.3f %12.3f %12.3f %12.3f\n", collisionBenchDensities[d], run.population,
+               timings.stepNanoseconds / 1e6 / timings.steps, samples[count / 2] / 1e6,
+               samples[(count * 99) / 100] / 1e6, samples[count - 1] / 1e6);
+    }
+
+    free(samples);
+
+    return EXIT_SUCCESS;
+}
+
+// Runs growing numbers of islands with one thread each and reports how the
+// organism steps per second scale. With as many cores as islands the
+// throughput should grow with the island count.
+int runIslandBenchmark(Simulation* sim)
+{
+    int cores = sim->threads > ISLAND_BENCH_MAX_ISLANDS ? sim->threads : ISLAND_BENCH_MAX_ISLANDS;
+    double baseline = 0.0;
+
+    printf("Islands of %d as %s, %d generations x %d steps, %d migrant(s) every %d generation(s) round a %s\n",
+           sim->population, sim->islandProcesses ? "processes" : "threads", ISLAND_BENCH_GENERATIONS,
+           ISLAND_BENCH_STEPS, sim->migrants, sim->migrationInterval, getMigrationTopologyName(sim->migration));
+    printf("%8s %12s %18s %10s %11s\n", "islands", "seconds", "org-steps/s", "speedup", "migration");
+
+    for (int islands = 1; islands <= cores; islands *= 2) {
+        Simulation run = *sim;
+        SimulationTimings timings = { 0 };
+
+        run.islands = islands;
+        run.threads = islands;
+        run.maxGenerations = ISLAND_BENCH_GENERATIONS;
+        run.stepsPerGeneration = ISLAND_BENCH_STEPS;
+        run.headless = true;
+        run.compareActivation = false;
+        run.quiet = true;
+        run.timings = &timings;
+        run.obstacleMap = createObstacleMap(run.size);
+        run.sensorField = createSensorField(run.size);
+        run.selectionMask = createSelectionMask(&run);
+
+        uint64_t start = nowInNanoseconds();
+        runIslands(&run);
+        double seconds = (nowInNanoseconds() - start) / 1e9;
+
+        destroyObstacleMap(&run.obstacleMap);
+        destroySensorField(&run.sensorField);
+        destroySelectionMask(&run.selectionMask);
+
+        double orgSteps = (double)timings.steps * run.population / seconds;
+        if (islands == 1) {
+            baseline = orgSteps;
+        }
+
+        // the share of generation time spent exchanging migrants, waiting included
+        double migration = timings.generationNanoseconds > 0 ?
+                           100.0 * timings.migrationNanoseconds / timings.generationNanoseconds : 0.0;
+
+        printf("%8d %12.3f %18.0f %9.2fx %10.3f%%\n", islands, seconds, orgSteps, orgSteps / baseline, migration);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+#include "CellSampler.h"
+
+#include <stdlib.h>
+
+#include "ObstacleMap.h"
+
+CellSampler createCellSampler(Simulation* sim)
+{
+    CellSampler sampler = {
+        .size = sim->size,
+        .cells = NULL,
+    };
+
+    if ((size_t)sim->size.w * sim->size.h > CELL_SAMPLER_MAX_CELLS) {
+        return sampler;
+    }
+
+    sampler.cells = malloc(countFreeCells(sim) * sizeof(uint32_t));
+
+    for (int y = 0; y < sim->size.h; y++) {
+        for (int x = 0; x < sim->size.w; x++) {
+            if (!isPosBlocked(&sim->obstacleMap, (Pos) { .x = x, .y = y })) {
+                sampler.cells[sampler.count++] = (uint32_t)y * sim->size.w + x;
+            }
+        }
+    }
+
+    return sampler;
+}
+
+void destroyCellSampler(CellSampler* sampler)
+{
+    free(sampler->cells);
+    sampler->cells = NULL;
+    sampler->count = 0;
+}
+
+size_t countFreeCells(Simulation* sim)
+{
+    return (size_t)sim->size.w * sim->size.h - countObstacleCells(&sim->obstacleMap);
+}
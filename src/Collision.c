@@ -0,0 +1,51 @@
+#include "Collision.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+CollisionOffset collisionSearchOrder[COLLISION_SEARCH_CELLS];
+int collisionRingStarts[COLLISION_SEARCH_CELLS + 1];
+int collisionRingCount;
+
+static int getDistanceSquared(CollisionOffset offset)
+{
+    return offset.x * offset.x + offset.y * offset.y;
+}
+
+static int compareOffsets(const void* a, const void* b)
+{
+    CollisionOffset* p = (CollisionOffset*)a;
+    CollisionOffset* q = (CollisionOffset*)b;
+
+    int pDistance = getDistanceSquared(*p), qDistance = getDistanceSquared(*q);
+    if (pDistance != qDistance) {
+        return pDistance - qDistance;
+    }
+
+    double pAngle = atan2(p->y, p->x), qAngle = atan2(q->y, q->x);
+    return (pAngle > qAngle) - (pAngle < qAngle);
+}
+
+// Works out the search order. Must be called before any organism acts.
+void initCollisionSearch(void)
+{
+    int n = 0;
+
+    for (int y = -COLLISION_SEARCH_RADIUS; y <= COLLISION_SEARCH_RADIUS; y++) {
+        for (int x = -COLLISION_SEARCH_RADIUS; x <= COLLISION_SEARCH_RADIUS; x++) {
+            collisionSearchOrder[n++] = (CollisionOffset) {
+                .x = x, .y = y
+            };
+        }
+    }
+
+    qsort(collisionSearchOrder, COLLISION_SEARCH_CELLS, sizeof(CollisionOffset), compareOffsets);
+
+    collisionRingCount = 0;
+    for (int i = 0; i < COLLISION_SEARCH_CELLS; i++) {
+        if (i == 0 || getDistanceSquared(collisionSearchOrder[i]) != getDistanceSquared(collisionSearchOrder[i - 1])) {
+            collisionRingStarts[collisionRingCount++] = i;
+        }
+    }
+    collisionRingStarts[collisionRingCount] = COLLISION_SEARCH_CELLS;
+}
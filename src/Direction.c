@@ -1,5 +1,3 @@
-#include <stdlib.h>
-
 #include "Direction.h"
 
 Direction turnLeft(Direction dir)
@@ -17,7 +15,7 @@ Direction turnBackwards(Direction dir)
     return (Direction)((dir + (DIR_MAX >> 2)) % DIR_MAX);
 }
 
-Direction getRandomDirection(void)
+Direction getRandomDirection(RandomStream* rng)
 {
-    return (Direction)(rand() % DIR_MAX);
+    return (Direction)randomBelow(rng, DIR_MAX);
 }
\ No newline at end of file
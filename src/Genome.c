@@ -1,9 +1,15 @@
 #include "Genome.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
+// Genes crossed over at once, a quarter of the genes each mask word covers.
+#define CROSSOVER_LANES 8
+
+typedef uint32_t GeneLanes __attribute__((vector_size(CROSSOVER_LANES * sizeof(Gene))));
+
 // make a deep copy of the genome
 Genome copyGenome(Genome* src, Gene* geneBuffer)
 {
@@ -15,42 +21,10 @@ Genome copyGenome(Genome* src, Gene* geneBuffer)
     return dest;
 }
 
-Gene intToGene(uint32_t n)
-{
-    return (Gene) {
-        .sourceIsInput = (bool)((n >> 31) & 0x01),
-        .sourceId = (uint8_t)((n >> 24) & 0x7f),
-        .sinkIsOutput = (bool)((n >> 23) & 0x01),
-        .sinkId = (uint8_t)((n >> 16) & 0x7f),
-        .weight = (uint16_t)(n & 0xffff),
-    };
-}
-
-uint32_t geneToInt(Gene *gene)
-{
-    return (uint32_t)(((gene->sourceIsInput << 7) | gene->sourceId) << 24) |
-           (uint32_t)(((gene->sinkIsOutput << 7) | gene->sinkId) << 16) |
-           (uint32_t)gene->weight;
-}
-
-void testGeneCreation()
-{
-    uint32_t geneInt = rand() % UINT32_MAX;
-
-    Gene gene = intToGene(geneInt);
-
-    uint32_t newGeneInt = geneToInt(&gene);
-
-    if (geneInt != newGeneInt) {
-        fprintf(stderr, "ERROR: %08X /= %08X\n", geneInt, newGeneInt);
-        exit(1);
-    }
-}
-
 char *geneToString(Gene *gene)
 {
     char *buffer = calloc(9, sizeof(char));
-    snprintf(buffer, 9, "%08X", geneToInt(gene));
+    snprintf(buffer, 9, "%08X", *gene);
     return buffer;
 }
 
@@ -69,65 +43,137 @@ char *genomeToString(Genome *genome)
     return buffer;
 }
 
-Genome mutateGenome(Genome genome, float mutationRate, bool* didMutate)
+// Draws how many genes go by unmutated before the next mutation.
+static uint64_t drawMutationGap(MutationSchedule* schedule)
 {
-    if ((float)rand() / (float)RAND_MAX >= mutationRate) {
-        if (didMutate != NULL) {
-            *didMutate = false;
-        }
-        return genome;
+    if (schedule->totalRate <= 0.0f) {
+        return UINT64_MAX;
     }
+    if (schedule->totalRate >= 1.0f) {
+        return 0;
+    }
+
+    // in (0, 1], so the log is finite
+    double u = 1.0 - randomFloat(&schedule->rng);
+    double gap = floor(log(u) / schedule->logKeepRate);
 
-    // flip a random bit
-    int idx = rand() % genome.count;
-    int geneInt = geneToInt(&genome.genes[idx]);
-    geneInt = geneInt ^ (1 << (rand() % 32));
-    genome.genes[idx] = intToGene(geneInt);
+    return gap >= (double)UINT64_MAX ? UINT64_MAX : (uint64_t)gap;
+}
+
+MutationSchedule createMutationSchedule(MutationRates rates, RandomStream rng)
+{
+    MutationSchedule schedule = {
+        .rates = rates,
+        .totalRate = rates.bitFlip + rates.weightPerturbation + rates.duplication,
+        .rng = rng,
+    };
+    schedule.logKeepRate = log1p(-(double)schedule.totalRate);
+    schedule.gap = drawMutationGap(&schedule);
+
+    return schedule;
+}
+
+// Applies one mutation to the gene at idx, of a kind picked in proportion to
+// its rate.
+static void mutateGene(Genome* genome, int idx, MutationSchedule* schedule)
+{
+    Gene* gene = &genome->genes[idx];
+    float kind = randomFloat(&schedule->rng) * schedule->totalRate;
+
+    if (kind < schedule->rates.bitFlip) {
+        *gene ^= 1u << randomBelow(&schedule->rng, 32);
+    } else if (kind < schedule->rates.bitFlip + schedule->rates.weightPerturbation) {
+        int weight = (int)getGeneWeight(*gene) + (int)randomBelow(&schedule->rng, 2 * MUTATION_WEIGHT_STEP + 1)
+                     - MUTATION_WEIGHT_STEP;
+        weight = weight < 0 ? 0 : weight > GENE_WEIGHT_MASK ? GENE_WEIGHT_MASK : weight;
+        *gene = (*gene & ~(Gene)GENE_WEIGHT_MASK) | (Gene)weight;
+    } else {
+        // genomes have a fixed length, so the copy replaces another gene
+        genome->genes[randomBelow(&schedule->rng, genome->count)] = *gene;
+    }
+
+    schedule->mutations++;
+}
+
+// Applies the mutations that the schedule puts within this genome, and moves
+// the schedule past it.
+Genome mutateGenome(Genome genome, MutationSchedule* schedule, bool* didMutate)
+{
+    bool mutated = false;
+
+    while (schedule->gap < genome.count) {
+        mutateGene(&genome, (int)schedule->gap, schedule);
+        mutated = true;
+
+        uint64_t next = drawMutationGap(schedule);
+        schedule->gap = next >= UINT64_MAX - schedule->gap - 1 ? UINT64_MAX : schedule->gap + 1 + next;
+    }
+
+    if (schedule->gap != UINT64_MAX) {
+        schedule->gap -= genome.count;
+    }
 
     if (didMutate != NULL) {
-        *didMutate = true;
+        *didMutate = mutated;
     }
 
     return genome;
 }
 
-uint32_t rand_uint32(void)
+Genome makeRandomGenome(uint8_t numGenes, Gene* geneBuffer, RandomStream* rng)
 {
-    return (uint32_t)((uint16_t)(rand()) << 16) | (uint16_t)rand();
+    Genome genome = {.count = numGenes, .genes = geneBuffer};
+
+    randomFill(rng, genome.genes, numGenes);
+
+    return genome;
 }
 
-Genome makeRandomGenome(uint8_t numGenes, Gene* geneBuffer)
+// Takes each of the first count genes from a where its bit in masks is clear
+// and from b where it is set, CROSSOVER_LANES genes at a time.
+__attribute__((target_clones("avx512f", "avx2", "default")))
+static void blendGenes(Gene* out, Gene* a, Gene* b, uint32_t* masks, int count)
 {
-    Genome genome = {.count = numGenes, .genes = geneBuffer};
+    const GeneLanes shifts = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    int i = 0;
 
-    for (int i = 0; i < numGenes; i++) {
-        genome.genes[i] = intToGene(rand_uint32());
+    for (; i + CROSSOVER_LANES <= count; i += CROSSOVER_LANES) {
+        GeneLanes fromA, fromB;
+        memcpy(&fromA, &a[i], sizeof(fromA));
+        memcpy(&fromB, &b[i], sizeof(fromB));
+
+        // all ones in the lanes that come from b
+        GeneLanes bits = (GeneLanes){ 0 } + (masks[i / 32] >> (i % 32));
+        GeneLanes select = -((bits >> shifts) & 1);
+
+        GeneLanes blended = (fromA & ~select) | (fromB & select);
+        memcpy(&out[i], &blended, sizeof(blended));
     }
 
-    return genome;
+    for (; i < count; i++) {
+        Gene select = -((masks[i / 32] >> (i % 32)) & 1);
+        out[i] = (a[i] & ~select) | (b[i] & select);
+    }
 }
 
-Genome reproduce(Genome *a, Genome *b, Gene* geneBuffer)
+Genome reproduce(Genome *a, Genome *b, Gene* geneBuffer, RandomStream* rng)
 {
     int largerCount = a->count > b->count ? a->count : b->count;
+    int smallerCount = a->count < b->count ? a->count : b->count;
 
     Genome genome = {.count = largerCount,
                      .genes = geneBuffer
                     };
 
-    for (int i = 0; i < largerCount; i++) {
-        if (i < a->count && i < b->count) {
-            if (rand() % 2 == 0) {
-                genome.genes[i] = a->genes[i];
-            } else {
-                genome.genes[i] = b->genes[i];
-            }
-        } else if (i < a->count) {
-            genome.genes[i] = a->genes[i];
-        } else {
-            genome.genes[i] = b->genes[i];
-        }
-    }
+    // one random bit per gene picks which parent it comes from
+    uint32_t masks[(UINT8_MAX + 31) / 32];
+    randomFill(rng, masks, (largerCount + 31) / 32);
+
+    blendGenes(genome.genes, a->genes, b->genes, masks, smallerCount);
+
+    // past the end of the shorter parent every gene comes from the longer one
+    Genome* longer = a->count > b->count ? a : b;
+    memcpy(&genome.genes[smallerCount], &longer->genes[smallerCount], (largerCount - smallerCount) * sizeof(Gene));
 
     return genome;
-}
\ No newline at end of file
+}
@@ -0,0 +1,133 @@
+#include "Image.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Reads the next whitespace separated header number, skipping # comments.
+static bool readHeaderNumber(FILE* file, int* out)
+{
+    int c;
+
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '#') {
+            while ((c = fgetc(file)) != EOF && c != '\n');
+        } else if (!isspace(c)) {
+            break;
+        }
+    }
+
+    if (c == EOF || !isdigit(c)) {
+        return false;
+    }
+
+    int n = 0;
+    do {
+        n = n * 10 + (c - '0');
+    } while ((c = fgetc(file)) != EOF && isdigit(c));
+
+    *out = n;
+    return true;
+}
+
+// Reads the next plain bitmap pixel, skipping whitespace and # comments. Each
+// pixel is a single '0' or '1', so pixels need nothing between them.
+static bool readBitmapDigit(FILE* file, int* out)
+{
+    int c;
+
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '#') {
+            while ((c = fgetc(file)) != EOF && c != '\n');
+        } else if (!isspace(c)) {
+            break;
+        }
+    }
+
+    if (c != '0' && c != '1') {
+        return false;
+    }
+
+    *out = c - '0';
+    return true;
+}
+
+// Reads one pixel and returns true if it is set. For bitmaps a set bit (black)
+// is, for greymaps anything darker than half brightness is.
+static bool readPixel(FILE* file, int format, int maxValue, int x, int* bits, bool* ok)
+{
+    int value = 0;
+
+    switch (format) {
+    case 1:
+        *ok = readBitmapDigit(file, &value);
+        return value != 0;
+    case 2:
+        *ok = readHeaderNumber(file, &value);
+        return value * 2 < maxValue;
+    case 4:
+        if (x % 8 == 0) {
+            *bits = fgetc(file);
+            *ok = *bits != EOF;
+        }
+        return (*bits >> (7 - x % 8)) & 1;
+    case 5:
+        value = fgetc(file);
+        if (maxValue > 255 && value != EOF) {
+            value = (value << 8) | fgetc(file);
+        }
+        *ok = value != EOF;
+        return value * 2 < maxValue;
+    }
+
+    *ok = false;
+    return false;
+}
+
+// Reads a PBM (P1/P4) or PGM (P2/P5) image into one bool per pixel, in row
+// order, that is true where the pixel is set. Returns NULL if the image can't
+// be read.
+bool* readBitmapImage(const char* filename, int* w, int* h)
+{
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Could not open %s\n", filename);
+        return NULL;
+    }
+
+    int format = 0, maxValue = 1;
+    *w = 0;
+    *h = 0;
+
+    if (fgetc(file) != 'P' || !readHeaderNumber(file, &format) ||
+            (format != 1 && format != 2 && format != 4 && format != 5) ||
+            !readHeaderNumber(file, w) || !readHeaderNumber(file, h) ||
+            ((format == 2 || format == 5) && !readHeaderNumber(file, &maxValue)) ||
+            *w <= 0 || *h <= 0 || maxValue <= 0) {
+        fprintf(stderr, "%s is not a PBM or PGM image\n", filename);
+        fclose(file);
+        return NULL;
+    }
+
+    // the single whitespace after the header has already been consumed
+
+    bool* pixels = calloc((size_t)*w * *h, sizeof(bool));
+    bool ok = true;
+
+    for (int y = 0; y < *h && ok; y++) {
+        int bits = 0;
+        for (int x = 0; x < *w && ok; x++) {
+            pixels[(size_t)y * *w + x] = readPixel(file, format, maxValue, x, &bits, &ok);
+        }
+    }
+
+    fclose(file);
+
+    if (!ok) {
+        fprintf(stderr, "%s is truncated\n", filename);
+        free(pixels);
+        return NULL;
+    }
+
+    return pixels;
+}
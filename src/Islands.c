@@ -0,0 +1,468 @@
+#define _GNU_SOURCE
+#include "Islands.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "Random.h"
+#include "Simulator.h"
+
+static const char* migrationTopologyNames[] = {
+    [MIGRATION_RING] = "ring",
+    [MIGRATION_FULL] = "full",
+};
+
+bool parseMigrationTopology(const char* name, MigrationTopology* topology)
+{
+    for (size_t i = 0; i < sizeof(migrationTopologyNames) / sizeof(migrationTopologyNames[0]); i++) {
+        if (strcmp(name, migrationTopologyNames[i]) == 0) {
+            *topology = (MigrationTopology)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* getMigrationTopologyName(MigrationTopology topology)
+{
+    return migrationTopologyNames[topology];
+}
+
+static uint64_t nowInNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+// Reads one taskset list of CPUs, such as 0,2,8-15, up to the next ':'.
+static bool parseCpuList(const char* list, cpu_set_t* cpus)
+{
+    const char* c = list;
+    CPU_ZERO(cpus);
+
+    while (true) {
+        char* end;
+        long first = strtol(c, &end, 10);
+        if (end == c || first < 0) return false;
+
+        long last = first;
+        if (*end == '-') {
+            c = end + 1;
+            last = strtol(c, &end, 10);
+            if (end == c || last < first) return false;
+        }
+        if (last >= CPU_SETSIZE) return false;
+
+        for (long cpu = first; cpu <= last; cpu++) {
+            CPU_SET(cpu, cpus);
+        }
+
+        c = end;
+        if (*c != ',') break;
+        c++;
+    }
+
+    return *c == ':' || *c == '\0';
+}
+
+// Finds the list of CPUs for an island among lists split by ':', starting
+// again from the first list once every list has been given out.
+static const char* findCpuList(const char* lists, int index)
+{
+    int listCount = 1;
+    for (const char* c = lists; *c != '\0'; c++) {
+        listCount += *c == ':';
+    }
+
+    const char* list = lists;
+    for (int i = 0; i < index % listCount; i++) {
+        list = strchr(list, ':') + 1;
+    }
+
+    return list;
+}
+
+static bool hasFinished(Island* island)
+{
+    return __atomic_load_n(&island->finished, __ATOMIC_ACQUIRE);
+}
+
+// Sends each neighbour its own draw of survivors, then replaces a run of
+// survivors with the migrants from each neighbour, before the next generation
+// is bred. Islands wait for each other here, so what an island receives only
+// depends on the seeds and never on how the threads or processes are
+// scheduled. A neighbour that has stopped, or crashed, sends nothing more and
+// is sent to in vain.
+void exchangeMigrants(Island* island, OrganismStore* orgs, SurvivorIndex* survivors, int generation)
+{
+    Simulation* sim = &island->sim;
+
+    if (sim->migrants == 0 || (generation + 1) % sim->migrationInterval != 0) {
+        return;
+    }
+
+    uint64_t start = nowInNanoseconds();
+    int epoch = (generation + 1) / sim->migrationInterval;
+    size_t genomeBytes = sim->numberOfGenes * sizeof(Gene);
+    size_t slot = (size_t)(epoch % MAILBOX_SLOTS) * sim->migrants * sim->numberOfGenes;
+    RandomStream rng = makeRandomStream(sim->seed, generation, 0, 0, RNG_MIGRATION);
+
+    for (int b = 0; b < island->outboxCount; b++) {
+        Mailbox* box = island->outboxes[b];
+
+        while (__atomic_load_n(&box->taken, __ATOMIC_ACQUIRE) < epoch - MAILBOX_SLOTS &&
+                !hasFinished(box->receiver)) {
+            sched_yield();
+        }
+
+        for (int m = 0; m < sim->migrants; m++) {
+            Organism* emigrant = &orgs->orgs[survivors->ids[sampleSurvivor(survivors, &rng)]];
+            memcpy(&box->genes[slot + m * sim->numberOfGenes], emigrant->genome.genes, genomeBytes);
+        }
+
+        __atomic_store_n(&box->posted, epoch, __ATOMIC_RELEASE);
+    }
+
+    // immigrants replace survivors from a random start, and never more of
+    // them than there are survivors, so none overwrites another
+    int next = randomBelow(&rng, survivors->count);
+    int arrived = 0;
+
+    for (int b = 0; b < island->inboxCount; b++) {
+        Mailbox* box = island->inboxes[b];
+
+        // posted is read again once the sender has stopped, in case it
+        // posted just before
+        while (__atomic_load_n(&box->posted, __ATOMIC_ACQUIRE) < epoch && !hasFinished(box->sender)) {
+            sched_yield();
+        }
+        if (__atomic_load_n(&box->posted, __ATOMIC_ACQUIRE) < epoch) {
+            continue;
+        }
+
+        for (int m = 0; m < sim->migrants && arrived < survivors->count; m++, arrived++) {
+            Organism* resident = &orgs->orgs[survivors->ids[next]];
+            memcpy(resident->genome.genes, &box->genes[slot + m * sim->numberOfGenes], genomeBytes);
+            next = (next + 1) % survivors->count;
+        }
+
+        __atomic_store_n(&box->taken, epoch, __ATOMIC_RELEASE);
+    }
+
+    island->timings.migrationNanoseconds += nowInNanoseconds() - start;
+}
+
+void recordIslandGeneration(Island* island, int generation, int survivors)
+{
+    island->survivors[generation] = survivors;
+}
+
+static void* islandWorker(void* args)
+{
+    Island* island = (Island*)args;
+    cpu_set_t cpus;
+
+    // this pins only the calling thread, and the threads it starts after it
+    if (island->cpus != NULL && parseCpuList(island->cpus, &cpus) &&
+            sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+        fprintf(stderr, "Could not pin island %d to CPUs %.*s: %s\n", island->index,
+                (int)strcspn(island->cpus, ":"), island->cpus, strerror(errno));
+    }
+
+    island->status = runSimulation(&island->sim);
+    __atomic_store_n(&island->finished, true, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+// Maps a block of POSIX shared memory that forked islands keep sharing. The
+// name is unlinked straight away, so nothing is left behind however the run
+// ends.
+static void* mapSharedBlock(size_t bytes)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/life-islands-%d", (int)getpid());
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        return NULL;
+    }
+    shm_unlink(name);
+
+    void* block = ftruncate(fd, bytes) == 0 ? mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+
+    return block == MAP_FAILED ? NULL : block;
+}
+
+static size_t roundToCacheLine(size_t bytes)
+{
+    return (bytes + 63) & ~(size_t)63;
+}
+
+// Takes the next bytes of a block, keeping every part on its own cache lines.
+static void* carveBlock(char* block, size_t* used, size_t bytes)
+{
+    void* part = block + *used;
+    *used += roundToCacheLine(bytes);
+    return part;
+}
+
+// Links every island to its neighbours: the next island round the ring, or
+// every other island.
+static void linkIslands(Island* islands, int count, Mailbox* boxes, int linksPerIsland, Gene* genes,
+                        Simulation* sim)
+{
+    size_t genesPerBox = (size_t)MAILBOX_SLOTS * sim->migrants * sim->numberOfGenes;
+    int linkCount = 0;
+
+    for (int i = 0; i < count; i++) {
+        for (int l = 0; l < linksPerIsland; l++) {
+            Island* receiver = &islands[(i + 1 + l) % count];
+            Mailbox* box = &boxes[linkCount];
+
+            box->sender = &islands[i];
+            box->receiver = receiver;
+            box->genes = &genes[linkCount * genesPerBox];
+            linkCount++;
+
+            islands[i].outboxes[islands[i].outboxCount++] = box;
+            receiver->inboxes[receiver->inboxCount++] = box;
+        }
+    }
+}
+
+// Forks each island into a process of its own. The parent ignores interrupts
+// meanwhile, so that an interrupt stops the islands, which still report what
+// they did, rather than the run.
+static void runIslandProcesses(Island* islands, int count)
+{
+    void (*interruptHandler)(int) = signal(SIGINT, SIG_IGN);
+    int running = 0;
+
+    fflush(stdout);
+    fflush(stderr);
+
+    for (int i = 0; i < count; i++) {
+        Island* island = &islands[i];
+
+        // the island is in shared memory, so only the parent may store the
+        // process in it
+        pid_t process = fork();
+        if (process == 0) {
+            islandWorker(island);
+
+            // _exit skips the stdio buffers, which would otherwise lose the
+            // island's last lines when its output is a pipe or file
+            fflush(stdout);
+            fflush(stderr);
+            _exit(island->status);
+        }
+
+        island->process = process;
+        if (process == -1) {
+            fprintf(stderr, "Could not start island %d: %s\n", i, strerror(errno));
+            island->status = EXIT_FAILURE;
+            __atomic_store_n(&island->finished, true, __ATOMIC_RELEASE);
+        } else {
+            running++;
+        }
+    }
+
+    // a crashed island never marks itself finished, so it is marked here
+    // and its neighbours carry on without it
+    while (running > 0) {
+        int result;
+        pid_t process = waitpid(-1, &result, 0);
+
+        if (process == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            Island* island = &islands[i];
+            if (island->process != process) continue;
+
+            if (WIFSIGNALED(result)) {
+                fprintf(stderr, "Island %d was stopped by signal %d (%s)\n", i, WTERMSIG(result),
+                        strsignal(WTERMSIG(result)));
+                island->status = EXIT_FAILURE;
+            } else {
+                island->status = WEXITSTATUS(result);
+            }
+
+            __atomic_store_n(&island->finished, true, __ATOMIC_RELEASE);
+            running--;
+        }
+    }
+
+    signal(SIGINT, interruptHandler);
+}
+
+static void runIslandThreads(Island* islands, int count)
+{
+    for (int i = 0; i < count; i++) {
+        Island* island = &islands[i];
+        int error = pthread_create(&island->thread, NULL, islandWorker, island);
+
+        island->started = error == 0;
+        if (!island->started) {
+            fprintf(stderr, "Could not start island %d: %s\n", i, strerror(error));
+            island->status = EXIT_FAILURE;
+            __atomic_store_n(&island->finished, true, __ATOMIC_RELEASE);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (islands[i].started) {
+            pthread_join(islands[i].thread, NULL);
+        }
+    }
+}
+
+// Evolves sim->islands populations of sim->population organisms at once, each
+// on its own thread or in its own process, and reports how many survived on
+// each island in each generation. Each island gets its own seed and the
+// threads are shared out between them. The islands, their mailboxes and what
+// they report are kept in one block, which is shared memory in process mode.
+int runIslands(Simulation* sim)
+{
+    int count = sim->islands;
+    int threadsPerIsland = sim->threads / count > 0 ? sim->threads / count : 1;
+    int linksPerIsland = count == 1 ? 0 : sim->migration == MIGRATION_RING ? 1 : count - 1;
+    int linkCount = count * linksPerIsland;
+
+    for (const char* list = sim->islandCpus; list != NULL; ) {
+        cpu_set_t cpus;
+
+        if (!parseCpuList(list, &cpus)) {
+            fprintf(stderr, "Could not parse CPU list %.*s.\n", (int)strcspn(list, ":"), list);
+            return EXIT_FAILURE;
+        }
+
+        list = strchr(list, ':');
+        list = list != NULL ? list + 1 : NULL;
+    }
+
+    size_t islandBytes = count * sizeof(Island);
+    size_t boxBytes = linkCount * sizeof(Mailbox);
+    size_t linkBytes = linkCount * sizeof(Mailbox*);
+    size_t geneBytes = (size_t)linkCount * MAILBOX_SLOTS * sim->migrants * sim->numberOfGenes * sizeof(Gene);
+    size_t survivorBytes = (size_t)count * sim->maxGenerations * sizeof(int);
+    size_t blockBytes = roundToCacheLine(islandBytes) + roundToCacheLine(boxBytes) + 2 * roundToCacheLine(linkBytes) +
+                        roundToCacheLine(geneBytes) + roundToCacheLine(survivorBytes);
+
+    char* block = sim->islandProcesses ? mapSharedBlock(blockBytes) : aligned_alloc(64, blockBytes);
+    if (block == NULL) {
+        fprintf(stderr, "Could not allocate %zu bytes for %d island(s): %s\n", blockBytes, count, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    memset(block, 0, blockBytes);
+
+    size_t used = 0;
+    Island* islands = carveBlock(block, &used, islandBytes);
+    Mailbox* boxes = carveBlock(block, &used, boxBytes);
+    Mailbox** outboxes = carveBlock(block, &used, linkBytes);
+    Mailbox** inboxes = carveBlock(block, &used, linkBytes);
+    Gene* genes = carveBlock(block, &used, geneBytes);
+    int* survivors = carveBlock(block, &used, survivorBytes);
+
+    for (int i = 0; i < count; i++) {
+        Island* island = &islands[i];
+
+        island->index = i;
+        island->sim = *sim;
+        island->sim.seed = sim->seed + i;
+        island->sim.threads = threadsPerIsland;
+        island->sim.headless = true;
+        island->sim.quiet = true;
+        island->sim.island = island;
+        island->sim.timings = &island->timings;
+        island->cpus = sim->islandCpus != NULL ? findCpuList(sim->islandCpus, i) : NULL;
+
+        island->outboxes = &outboxes[i * linksPerIsland];
+        island->inboxes = &inboxes[i * linksPerIsland];
+
+        island->survivors = &survivors[i * sim->maxGenerations];
+        for (int g = 0; g < sim->maxGenerations; g++) {
+            island->survivors[g] = -1;
+        }
+    }
+
+    linkIslands(islands, count, boxes, linksPerIsland, genes, sim);
+
+    if (!sim->quiet) {
+        printf("Seed is %d\n", sim->seed);
+        printf("Evolving %d island(s) of %d as %s on %d thread(s) each, sending %d migrant(s) every %d "
+               "generation(s) round a %s\n", count, sim->population, sim->islandProcesses ? "processes" : "threads",
+               threadsPerIsland, sim->migrants, sim->migrationInterval, getMigrationTopologyName(sim->migration));
+    }
+
+    if (sim->islandProcesses) {
+        runIslandProcesses(islands, count);
+    } else {
+        runIslandThreads(islands, count);
+    }
+
+    int status = EXIT_SUCCESS;
+    SimulationTimings total = { 0 };
+
+    for (int i = 0; i < count; i++) {
+        if (islands[i].status != EXIT_SUCCESS) {
+            status = islands[i].status;
+        }
+
+        total.generations += islands[i].timings.generations;
+        total.steps += islands[i].timings.steps;
+        total.stepNanoseconds += islands[i].timings.stepNanoseconds;
+        total.actNanoseconds += islands[i].timings.actNanoseconds;
+        total.generationNanoseconds += islands[i].timings.generationNanoseconds;
+        total.migrationNanoseconds += islands[i].timings.migrationNanoseconds;
+    }
+
+    for (int g = 0; g < sim->maxGenerations && !sim->quiet; g++) {
+        int living = 0, islandsRunning = 0;
+        char line[16 * 12] = "";
+        size_t length = 0;
+
+        for (int i = 0; i < count; i++) {
+            if (islands[i].survivors[g] == -1) continue;
+
+            living += islands[i].survivors[g];
+            islandsRunning++;
+            if (length < sizeof(line) - 12) {
+                length += snprintf(&line[length], sizeof(line) - length, " %d", islands[i].survivors[g]);
+            }
+        }
+
+        if (islandsRunning == 0) break;
+
+        printf("Gen %d survival rate is %.2f%% across %d island(s):%s%s\n", g,
+               living * 100.0f / ((float)islandsRunning * sim->population), islandsRunning, line,
+               length >= sizeof(line) - 12 ? " ..." : "");
+    }
+
+    if (sim->timings != NULL) {
+        *sim->timings = total;
+    }
+
+    if (sim->islandProcesses) {
+        munmap(block, blockBytes);
+    } else {
+        free(block);
+    }
+
+    return status;
+}
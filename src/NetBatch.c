@@ -0,0 +1,300 @@
+// The lanes have to produce exactly what runNeuralNet would, so multiplies and
+// adds must not be fused into FMAs in the wider clones.
+#pragma GCC optimize ("fp-contract=off")
+
+#include "NetBatch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Activation.h"
+#include "NeuralNet.h"
+#include "OrganismStore.h"
+
+typedef float NetLanes __attribute__((vector_size(NET_BATCH_LANES * sizeof(float))));
+
+#define NET_BATCH_ALIGNMENT sizeof(NetLanes)
+
+NetBatch createNetBatch(int capacity)
+{
+    int hashTableSize = 1;
+    while (hashTableSize < 2 * capacity) {
+        hashTableSize <<= 1;
+    }
+
+    return (NetBatch) {
+        .capacity = capacity,
+        .groups = calloc(capacity, sizeof(NetGroup)),
+        .groupHashes = calloc(capacity, sizeof(uint64_t)),
+        .hashTable = calloc(hashTableSize, sizeof(int)),
+        .hashTableSize = hashTableSize,
+        .members = calloc(capacity, sizeof(OrganismId)),
+        .memberGroup = calloc(capacity, sizeof(int)),
+        .blocks = calloc(capacity, sizeof(NetBlock)),
+        .scalar = calloc(capacity, sizeof(OrganismId)),
+    };
+}
+
+void destroyNetBatch(NetBatch* batch)
+{
+    free(batch->groups);
+    batch->groups = NULL;
+
+    free(batch->groupHashes);
+    batch->groupHashes = NULL;
+
+    free(batch->hashTable);
+    batch->hashTable = NULL;
+
+    free(batch->members);
+    batch->members = NULL;
+
+    free(batch->memberGroup);
+    batch->memberGroup = NULL;
+
+    free(batch->blocks);
+    batch->blocks = NULL;
+
+    free(batch->scalar);
+    batch->scalar = NULL;
+
+    free(batch->storage);
+    batch->storage = NULL;
+    batch->storageCapacity = 0;
+}
+
+// FNV-1a over everything that decides how a net is evaluated, but not its
+// weights.
+static uint64_t hashNetShape(NeuralNet* net)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+#define HASH_WORD(w) do { hash ^= (uint64_t)(w); hash *= 0x100000001b3ull; } while (0)
+    HASH_WORD(net->neuronCount);
+    HASH_WORD(net->activeConnectionCount);
+    for (int i = 0; i < net->activeConnectionCount; i++) {
+        NeuralConnection* c = &net->connections[i];
+        HASH_WORD(((uint32_t)c->source << 16) | c->sink);
+        HASH_WORD((uint32_t)c->divisor);
+    }
+#undef HASH_WORD
+
+    return hash;
+}
+
+static bool isSameNetShape(NeuralNet* a, NeuralNet* b)
+{
+    if (a->neuronCount != b->neuronCount || a->activeConnectionCount != b->activeConnectionCount) {
+        return false;
+    }
+
+    for (int i = 0; i < a->activeConnectionCount; i++) {
+        NeuralConnection* ca = &a->connections[i];
+        NeuralConnection* cb = &b->connections[i];
+        if (ca->source != cb->source || ca->sink != cb->sink || ca->divisor != cb->divisor) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int findOrAddNetGroup(NetBatch* batch, NeuralNet* net)
+{
+    uint64_t hash = hashNetShape(net);
+    int mask = batch->hashTableSize - 1;
+
+    // slots hold group index + 1 so that zero means empty
+    for (int slot = hash & mask;; slot = (slot + 1) & mask) {
+        int entry = batch->hashTable[slot];
+
+        if (entry == 0) {
+            int g = batch->groupCount++;
+            batch->groups[g] = (NetGroup) {
+                .shape = net,
+                .neuronCount = net->neuronCount,
+                .connectionCount = net->activeConnectionCount,
+                .organismCount = 0,
+            };
+            batch->groupHashes[g] = hash;
+            batch->hashTable[slot] = g + 1;
+            return g;
+        }
+
+        int g = entry - 1;
+        if (batch->groupHashes[g] == hash && isSameNetShape(batch->groups[g].shape, net)) {
+            return g;
+        }
+    }
+}
+
+static void reserveNetBatchStorage(NetBatch* batch, size_t bytes)
+{
+    if (bytes <= batch->storageCapacity) return;
+
+    free(batch->storage);
+    bytes = (bytes + NET_BATCH_ALIGNMENT - 1) / NET_BATCH_ALIGNMENT * NET_BATCH_ALIGNMENT;
+    batch->storage = aligned_alloc(NET_BATCH_ALIGNMENT, bytes);
+    batch->storageCapacity = bytes;
+}
+
+// Groups the organisms by the shape of their nets and copies the weights of
+// every group large enough to be worth it into lanes, ready to be evaluated
+// with activation. Nets without outputs are left out, since nothing reads
+// them. Called whenever a new generation's nets have been built.
+void buildNetBatch(NetBatch* batch, OrganismStore* orgs, ActivationMode activation)
+{
+    batch->activation = activation;
+    memset(batch->hashTable, 0, batch->hashTableSize * sizeof(int));
+    batch->groupCount = 0;
+    batch->blockCount = 0;
+    batch->scalarCount = 0;
+
+    for (int i = 0; i < orgs->count; i++) {
+        if (getOrganism(orgs, i)->net.outputCount == 0) {
+            batch->memberGroup[i] = -1;
+            continue;
+        }
+
+        int g = findOrAddNetGroup(batch, &getOrganism(orgs, i)->net);
+        batch->memberGroup[i] = g;
+        batch->groups[g].organismCount++;
+    }
+
+    // lay the members out group by group, keeping id order within a group
+    int first = 0;
+    for (int g = 0; g < batch->groupCount; g++) {
+        batch->groups[g].firstMember = first;
+        first += batch->groups[g].organismCount;
+        batch->groups[g].organismCount = 0;
+    }
+    for (int i = 0; i < orgs->count; i++) {
+        if (batch->memberGroup[i] == -1) continue;
+
+        NetGroup* group = &batch->groups[batch->memberGroup[i]];
+        batch->members[group->firstMember + group->organismCount++] = i;
+    }
+
+    size_t storageSize = 0;
+    for (int g = 0; g < batch->groupCount; g++) {
+        NetGroup* group = &batch->groups[g];
+
+        if (group->organismCount < NET_BATCH_MIN_GROUP) {
+            for (int m = 0; m < group->organismCount; m++) {
+                batch->scalar[batch->scalarCount++] = batch->members[group->firstMember + m];
+            }
+            continue;
+        }
+
+        for (int m = 0; m < group->organismCount; m += NET_BATCH_LANES) {
+            int lanes = group->organismCount - m;
+            NetBlock* block = &batch->blocks[batch->blockCount++];
+
+            *block = (NetBlock) {
+                .group = g,
+                .firstMember = group->firstMember + m,
+                .laneCount = lanes < NET_BATCH_LANES ? lanes : NET_BATCH_LANES,
+                .weights = storageSize,
+                .states = storageSize + group->connectionCount * sizeof(NetLanes),
+            };
+            storageSize += (group->connectionCount + group->neuronCount) * sizeof(NetLanes);
+        }
+    }
+
+    reserveNetBatchStorage(batch, storageSize);
+    batch->storageSize = storageSize;
+    memset(batch->storage, 0, storageSize);
+
+    for (int b = 0; b < batch->blockCount; b++) {
+        NetBlock* block = &batch->blocks[b];
+        NetGroup* group = &batch->groups[block->group];
+        char* weights = (char*)batch->storage + block->weights;
+
+        for (int lane = 0; lane < block->laneCount; lane++) {
+            NeuralNet* net = &getOrganism(orgs, batch->members[block->firstMember + lane])->net;
+            for (int c = 0; c < group->connectionCount; c++) {
+                ((float*)weights)[c * NET_BATCH_LANES + lane] = net->connections[c].weight;
+            }
+        }
+    }
+}
+
+// The same sequence of operations as runNeuralNet, on every lane at once.
+__attribute__((target_clones("avx512f", "avx2", "default")))
+static void runNetLanes(NeuralConnection* connections, int connectionCount, const NetLanes* weights, NetLanes* states, ActivationMode activation)
+{
+    for (int i = 0; i < connectionCount; i++) {
+        NeuralConnection* connection = &connections[i];
+
+        states[connection->sink] += weights[i] * states[connection->source];
+
+        if (connection->divisor != 0.0f) {
+            activateLanes((float*)&states[connection->sink], NET_BATCH_LANES, connection->divisor, activation);
+        }
+    }
+}
+
+static void runNetBlock(NetBatch* batch, NetBlock* block, OrganismStore* orgs)
+{
+    NetGroup* group = &batch->groups[block->group];
+    float* states = (float*)((char*)batch->storage + block->states);
+
+    memset(states, 0, group->neuronCount * sizeof(NetLanes));
+
+    for (int lane = 0; lane < block->laneCount; lane++) {
+        OrganismId id = batch->members[block->firstMember + lane];
+        if (!isOrganismAlive(orgs, id)) continue;
+        Organism* org = getOrganism(orgs, id);
+
+        for (int n = 0; n < group->neuronCount; n++) {
+            states[n * NET_BATCH_LANES + lane] = org->net.neurons[n].state;
+        }
+    }
+
+    runNetLanes(group->shape->connections, group->connectionCount,
+                (const NetLanes*)((char*)batch->storage + block->weights), (NetLanes*)states, batch->activation);
+
+    for (int lane = 0; lane < block->laneCount; lane++) {
+        OrganismId id = batch->members[block->firstMember + lane];
+        if (!isOrganismAlive(orgs, id)) continue;
+        Organism* org = getOrganism(orgs, id);
+
+        for (int n = 0; n < group->neuronCount; n++) {
+            org->net.neurons[n].state = states[n * NET_BATCH_LANES + lane];
+        }
+    }
+}
+
+typedef struct {
+    NetBatch* batch;
+    OrganismStore* orgs;
+} NetBatchJob;
+
+static void netBatchWorker(void* ctx, int start, int end)
+{
+    NetBatchJob* job = (NetBatchJob*)ctx;
+    NetBatch* batch = job->batch;
+
+    for (int i = start; i < end; i++) {
+        if (i < batch->blockCount) {
+            runNetBlock(batch, &batch->blocks[i], job->orgs);
+        } else {
+            OrganismId id = batch->scalar[i - batch->blockCount];
+            if (isOrganismAlive(job->orgs, id)) {
+                runNeuralNet(&getOrganism(job->orgs, id)->net, batch->activation);
+            }
+        }
+    }
+}
+
+// Evaluates the nets of every living organism with the activation the batch
+// was built for. Their input neurons must already have been excited.
+void runNetBatch(NetBatch* batch, OrganismStore* orgs, ThreadPool* pool)
+{
+    NetBatchJob job = {
+        .batch = batch,
+        .orgs = orgs,
+    };
+
+    threadPoolParallelFor(pool, batch->blockCount + batch->scalarCount, netBatchWorker, &job);
+}
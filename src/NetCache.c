@@ -0,0 +1,176 @@
+#include "NetCache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "NeuralNet.h"
+
+NetCache createNetCache(int capacity)
+{
+    int bucketCount = 1;
+    while (bucketCount < capacity) {
+        bucketCount <<= 1;
+    }
+
+    NetCache cache = {
+        .capacity = capacity,
+        .entries = calloc(capacity, sizeof(NetCacheEntry)),
+        .freeEntry = capacity > 0 ? 0 : -1,
+        .buckets = malloc(bucketCount * sizeof(int)),
+        .bucketCount = bucketCount,
+    };
+
+    for (int i = 0; i < capacity; i++) {
+        cache.entries[i].next = i + 1 < capacity ? i + 1 : -1;
+    }
+    for (int b = 0; b < bucketCount; b++) {
+        cache.buckets[b] = -1;
+    }
+
+    return cache;
+}
+
+void destroyNetCache(NetCache* cache)
+{
+    for (int i = 0; i < cache->capacity; i++) {
+        free(cache->entries[i].storage);
+    }
+
+    free(cache->entries);
+    cache->entries = NULL;
+
+    free(cache->buckets);
+    cache->buckets = NULL;
+
+    cache->capacity = 0;
+    cache->liveEntries = 0;
+    cache->liveBytes = 0;
+}
+
+// FNV-1a over the genes, a word at a time.
+static uint64_t hashGenome(Genome* genome)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (int i = 0; i < genome->count; i++) {
+        hash ^= genome->genes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+static int findNetCacheEntry(NetCache* cache, Genome* genome, uint64_t hash)
+{
+    for (int e = cache->buckets[hash & (cache->bucketCount - 1)]; e != -1; e = cache->entries[e].next) {
+        NetCacheEntry* entry = &cache->entries[e];
+
+        if (entry->hash == hash && entry->geneCount == genome->count &&
+                memcmp(entry->genes, genome->genes, genome->count * sizeof(Gene)) == 0) {
+            return e;
+        }
+    }
+
+    return -1;
+}
+
+// Builds the net for a genome that is not in the cache yet, keeping a copy of
+// the genes, the neurons and the connections in one allocation of just the
+// size they need.
+static int addNetCacheEntry(NetCache* cache, Genome* genome, Simulation* sim, uint64_t hash)
+{
+    Neuron neurons[MAX_NEURONS] = { 0 };
+    NeuralConnection connections[MAX_CONNECTIONS];
+    NeuralNet net = buildNeuralNet(genome, sim, neurons, connections);
+
+    size_t geneBytes = genome->count * sizeof(Gene);
+    size_t neuronBytes = net.neuronCount * sizeof(Neuron);
+    size_t connectionBytes = net.connectionCount * sizeof(NeuralConnection);
+
+    int e = cache->freeEntry;
+    NetCacheEntry* entry = &cache->entries[e];
+    cache->freeEntry = entry->next;
+
+    // connections first, so that every part stays aligned
+    char* storage = malloc(connectionBytes + neuronBytes + geneBytes);
+    memcpy(storage, connections, connectionBytes);
+    memcpy(storage + connectionBytes, neurons, neuronBytes);
+    memcpy(storage + connectionBytes + neuronBytes, genome->genes, geneBytes);
+
+    *entry = (NetCacheEntry) {
+        .hash = hash,
+        .refs = 0,
+        .geneCount = genome->count,
+        .genes = (Gene*)(storage + connectionBytes + neuronBytes),
+        .net = net,
+        .storage = storage,
+        .bytes = connectionBytes + neuronBytes + geneBytes,
+    };
+    entry->net.connections = (NeuralConnection*)storage;
+    entry->net.neurons = (Neuron*)(storage + connectionBytes);
+
+    int bucket = hash & (cache->bucketCount - 1);
+    entry->next = cache->buckets[bucket];
+    cache->buckets[bucket] = e;
+
+    cache->liveEntries++;
+    cache->liveBytes += entry->bytes;
+    if (cache->liveBytes > cache->peakBytes) {
+        cache->peakBytes = cache->liveBytes;
+    }
+
+    return e;
+}
+
+// Returns the net for a genome, building it only if no living organism has
+// the same genome. The neurons are copied into just enough room from arena
+// and the connections must not be written to. The net must be given back
+// with releaseNeuralNet.
+NeuralNet acquireNeuralNet(NetCache* cache, Genome* genome, Simulation* sim, Arena* arena)
+{
+    uint64_t hash = hashGenome(genome);
+    int e = findNetCacheEntry(cache, genome, hash);
+
+    cache->lookups++;
+    if (e == -1) {
+        e = addNetCacheEntry(cache, genome, sim, hash);
+    } else {
+        cache->hits++;
+    }
+
+    NetCacheEntry* entry = &cache->entries[e];
+    entry->refs++;
+
+    NeuralNet net = entry->net;
+    net.neurons = arenaAlloc(arena, net.neuronCount * sizeof(Neuron));
+    net.cacheEntry = e;
+    memcpy(net.neurons, entry->net.neurons, net.neuronCount * sizeof(Neuron));
+
+    return net;
+}
+
+void releaseNeuralNet(NetCache* cache, NeuralNet* net)
+{
+    int e = net->cacheEntry;
+    if (e == -1) return;
+
+    net->cacheEntry = -1;
+
+    NetCacheEntry* entry = &cache->entries[e];
+    if (--entry->refs > 0) return;
+
+    int* link = &cache->buckets[entry->hash & (cache->bucketCount - 1)];
+    while (*link != e) {
+        link = &cache->entries[*link].next;
+    }
+    *link = entry->next;
+
+    entry->next = cache->freeEntry;
+    cache->freeEntry = e;
+
+    free(entry->storage);
+    entry->storage = NULL;
+
+    cache->liveEntries--;
+    cache->liveBytes -= entry->bytes;
+}
@@ -1,8 +1,12 @@
 #include "NeuralNet.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "Activation.h"
+#include "Genome.h"
+
 Neuron *findNeuronById(Neuron* neurons, size_t neuronCount, uint16_t id)
 {
     for (int i = 0; i < neuronCount; i++) {
@@ -13,42 +17,161 @@ Neuron *findNeuronById(Neuron* neurons, size_t neuronCount, uint16_t id)
     return NULL;
 }
 
-NeuralNet buildNeuralNet(Genome *genome, Simulation* sim, Neuron* neuronBuffer, NeuralConnection* connectionBuffer)
+// Works out which neurons a gene connects and with what weight. Only the ids
+// and weight of the returned connection are filled in.
+NeuralConnection decodeGene(Gene* gene, Simulation* sim)
 {
-    uint8_t usedNeurons = 0;
-    uint8_t usedConnections = 0;
+    uint16_t sourceId = getGeneSourceId(*gene);
+    if (isGeneSourceInput(*gene)) {
+        sourceId %= IN_MAX;
+        sourceId |= IN_BASE;
+    } else {
+        sourceId %= sim->maxInternalNeurons;
+        sourceId |= INTERNAL_BASE;
+    }
 
-    for (int i = 0; i < genome->count; i++) {
-        Gene *gene = &genome->genes[i];
+    uint16_t sinkId = getGeneSinkId(*gene);
+    if (isGeneSinkOutput(*gene)) {
+        sinkId %= OUT_MAX;
+        sinkId |= OUT_BASE;
+    } else {
+        sinkId %= sim->maxInternalNeurons;
+        sinkId |= INTERNAL_BASE;
+    }
 
-        uint16_t sourceId = gene->sourceId;
-        if (gene->sourceIsInput) {
-            sourceId %= IN_MAX;
-            sourceId |= IN_BASE;
-        } else {
-            sourceId %= sim->maxInternalNeurons;
-            sourceId |= INTERNAL_BASE;
+    return (NeuralConnection) {
+        .sourceId = sourceId,
+        .sinkId = sinkId,
+        .weight = (float)getGeneWeight(*gene) * 8.0f / 65536.0f - 4.0f, // between -4.0 and +4.0
+    };
+}
+
+// Writes the connections into net->connections in the order they fire and
+// returns how many of them ever fire.
+//
+// A connection fires once its source has received all of its inputs, and a
+// sink is normalised as soon as its last input has fired. This only depends on
+// the shape of the net, so the order is worked out once here by sweeping over
+// the connections in gene order until nothing more can fire, and every step
+// then simply replays it. Connections out of a neuron that waits on itself
+// (a self-loop, or any cycle) can never fire and are moved to the end.
+static uint16_t orderConnections(NeuralNet* net, NeuralConnection* connections)
+{
+    bool fired[MAX_CONNECTIONS] = { false };
+    uint8_t inputsFired[MAX_NEURONS] = { 0 };
+    uint16_t count = 0;
+    int fires;
+
+    do {
+        fires = 0;
+
+        for (int i = 0; i < net->connectionCount; i++) {
+            NeuralConnection* conn = &connections[i];
+            Neuron* source = &net->neurons[conn->source];
+            Neuron* sink = &net->neurons[conn->sink];
+
+            if (fired[i] || (source->inputs && inputsFired[conn->source] < source->inputs)) {
+                continue;
+            }
+
+            inputsFired[conn->sink]++;
+            fired[i] = true;
+
+            NeuralConnection* ordered = &net->connections[count++];
+            *ordered = *conn;
+            if (inputsFired[conn->sink] == sink->inputs) {
+                ordered->divisor = (float)sink->inputs;
+            }
+
+            fires++;
         }
+    } while (fires > 0);
 
-        uint16_t sinkId = gene->sinkId;
-        if (gene->sinkIsOutput) {
-            sinkId %= OUT_MAX;
-            sinkId |= OUT_BASE;
-        } else {
-            sinkId %= sim->maxInternalNeurons;
-            sinkId |= INTERNAL_BASE;
+    uint16_t activeCount = count;
+
+    for (int i = 0; i < net->connectionCount; i++) {
+        if (!fired[i]) {
+            net->connections[count++] = connections[i];
         }
+    }
+
+    return activeCount;
+}
+
+// Moves the connections that fire but whose sinks never reach an output
+// neuron behind the ones that do, keeping both in firing order, and returns
+// how many are left to evaluate. Also works out which inputs those connections
+// read.
+//
+// A connection only ever fires after every input of its source has, so going
+// backwards through the firing order sees all the connections out of a neuron
+// before any connection into it.
+static uint16_t pruneConnections(NeuralNet* net, uint16_t activeCount)
+{
+    bool liveNeurons[MAX_NEURONS];
+    NeuralConnection dead[MAX_CONNECTIONS];
+    bool liveConnections[MAX_CONNECTIONS];
+
+    net->outputCount = 0;
+    for (int n = 0; n < net->neuronCount; n++) {
+        liveNeurons[n] = net->neurons[n].type == NEURON_OUTPUT;
+        net->outputCount += liveNeurons[n];
+    }
+
+    for (int i = activeCount - 1; i >= 0; i--) {
+        NeuralConnection* conn = &net->connections[i];
+
+        liveConnections[i] = liveNeurons[conn->sink];
+        if (liveConnections[i]) {
+            liveNeurons[conn->source] = true;
+        }
+    }
+
+    uint16_t liveCount = 0;
+    uint16_t deadCount = 0;
+    net->liveInputs = 0;
+
+    for (int i = 0; i < activeCount; i++) {
+        NeuralConnection* conn = &net->connections[i];
+
+        if (!liveConnections[i]) {
+            dead[deadCount++] = *conn;
+            continue;
+        }
+
+        if (net->neurons[conn->source].type == NEURON_INPUT) {
+            net->liveInputs |= 1u << (net->neurons[conn->source].id & 0xff);
+        }
+        net->connections[liveCount++] = *conn;
+    }
+
+    memcpy(&net->connections[liveCount], dead, deadCount * sizeof(NeuralConnection));
+
+    return liveCount;
+}
+
+NeuralNet buildNeuralNet(Genome *genome, Simulation* sim, Neuron* neuronBuffer, NeuralConnection* connectionBuffer)
+{
+    int usedNeurons = 0;
+    int usedConnections = 0;
+
+    // one connection per gene, which main keeps to at most MAX_CONNECTIONS
+    NeuralConnection connections[MAX_CONNECTIONS];
+
+    for (int i = 0; i < genome->count; i++) {
+        Gene *gene = &genome->genes[i];
+        NeuralConnection geneConnection = decodeGene(gene, sim);
+        uint16_t sourceId = geneConnection.sourceId;
+        uint16_t sinkId = geneConnection.sinkId;
 
         Neuron *source = findNeuronById(neuronBuffer, usedNeurons, sourceId);
         if (source == NULL) {
             source = &neuronBuffer[usedNeurons++];
             source->id = sourceId;
-            source->type = gene->sourceIsInput ? NEURON_INPUT : NEURON_INTERNAL;
+            source->type = isGeneSourceInput(*gene) ? NEURON_INPUT : NEURON_INTERNAL;
             source->state = 0.0f;
             source->inputs = 0;
             source->outputs = 1;
-            source->inputsVisited = 0;
-            source->outputsVisited = 0;
         } else {
             source->outputs++;
         }
@@ -57,22 +180,21 @@ NeuralNet buildNeuralNet(Genome *genome, Simulation* sim, Neuron* neuronBuffer,
         if (sink == NULL) {
             sink = &neuronBuffer[usedNeurons++];
             sink->id = sinkId;
-            sink->type = gene->sinkIsOutput ? NEURON_OUTPUT : NEURON_INTERNAL;
+            sink->type = isGeneSinkOutput(*gene) ? NEURON_OUTPUT : NEURON_INTERNAL;
             sink->state = 0.0f;
             sink->inputs = 1;
             sink->outputs = 0;
-            sink->inputsVisited = 0;
-            sink->outputsVisited = 0;
         } else {
             sink->inputs++;
         }
 
-        NeuralConnection *conn = &connectionBuffer[usedConnections++];
+        NeuralConnection *conn = &connections[usedConnections++];
         conn->sourceId = source->id;
         conn->sinkId = sink->id;
-        conn->weight =
-            (float)gene->weight * 8.0f / 65536.0f - 4.0f; // between -4.0 and +4.0
-        conn->visited = false;
+        conn->source = source - neuronBuffer;
+        conn->sink = sink - neuronBuffer;
+        conn->weight = geneConnection.weight;
+        conn->divisor = 0.0f;
     }
 
     NeuralNet net;
@@ -83,14 +205,83 @@ NeuralNet buildNeuralNet(Genome *genome, Simulation* sim, Neuron* neuronBuffer,
     net.neuronCount = usedNeurons;
     net.neurons = neuronBuffer;
 
+    net.activeConnectionCount = pruneConnections(&net, orderConnections(&net, connections));
+    net.cacheEntry = -1;
+
     return net;
 }
 
+// Replays the connections in the order worked out by buildNeuralNet, which is
+// the same order the inputs of each neuron have always been summed in.
+void runNeuralNet(NeuralNet* net, ActivationMode activation)
+{
+    Neuron* neurons = net->neurons;
+
+    for (int i = 0; i < net->activeConnectionCount; i++) {
+        NeuralConnection *connection = &net->connections[i];
+        Neuron *sink = &neurons[connection->sink];
+
+        sink->state += connection->weight * neurons[connection->source].state;
+
+        // normalise the sink state if it has been completed between -1.0 and 1.0.
+        if (connection->divisor != 0.0f) {
+            sink->state = activate(sink->state / connection->divisor, activation);
+        }
+    }
+}
+
+// Which way an output pushes the organism, going by the +-0.5 thresholds that
+// performNeuronOutputs acts on.
+static int outputDecision(float state)
+{
+    return state >= 0.5f ? 1 : state <= -0.5f ? -1 : 0;
+}
+
+// Evaluates the net with activation, and a copy of it with other, and
+// reports how far the copy's outputs ended up from the net's.
+NetDivergence compareNeuralNet(NeuralNet* net, ActivationMode activation, ActivationMode other)
+{
+    Neuron neurons[MAX_NEURONS];
+    memcpy(neurons, net->neurons, net->neuronCount * sizeof(Neuron));
+
+    NeuralNet copy = *net;
+    copy.neurons = neurons;
+
+    runNeuralNet(net, activation);
+    runNeuralNet(&copy, other);
+
+    NetDivergence divergence = { 0 };
+    for (int i = 0; i < net->neuronCount; i++) {
+        if (net->neurons[i].type != NEURON_OUTPUT) continue;
+
+        float difference = fabsf(net->neurons[i].state - neurons[i].state);
+        if (difference > divergence.maxOutputDifference) {
+            divergence.maxOutputDifference = difference;
+        }
+        if (outputDecision(net->neurons[i].state) != outputDecision(neurons[i].state)) {
+            divergence.decisionsChanged++;
+        }
+        divergence.outputsCompared++;
+    }
+
+    return divergence;
+}
+
+void addNetDivergence(NetDivergence* total, NetDivergence divergence)
+{
+    if (divergence.maxOutputDifference > total->maxOutputDifference) {
+        total->maxOutputDifference = divergence.maxOutputDifference;
+    }
+    total->outputsCompared += divergence.outputsCompared;
+    total->decisionsChanged += divergence.decisionsChanged;
+}
+
 void destroyNeuralNet(NeuralNet *net)
 {
     net->connections = NULL;
     net->neurons = NULL;
     net->connectionCount = 0;
+    net->activeConnectionCount = 0;
     net->neuronCount = 0;
 }
 
@@ -99,6 +290,7 @@ NeuralNet copyNeuralNet(NeuralNet* src, Neuron* neuronBuffer, NeuralConnection*
 {
     NeuralNet dest = *src;
 
+    dest.cacheEntry = -1;
     dest.connections = connectionBuffer;
     memcpy(dest.connections, src->connections, src->connectionCount * sizeof(NeuralConnection));
 
@@ -0,0 +1,90 @@
+#include "ObstacleMap.h"
+
+#include <stdlib.h>
+
+#include "Image.h"
+
+ObstacleMap createObstacleMap(Size size)
+{
+    return (ObstacleMap) {
+        .size = size,
+        .tiles = createTileMap(OBSTACLE_TILE_SIDE * sizeof(uint64_t), getTileGridSize(size, OBSTACLE_TILE_SHIFT),
+                               OBSTACLE_MAX_DENSE_TILES),
+    };
+}
+
+void destroyObstacleMap(ObstacleMap* map)
+{
+    destroyTileMap(&map->tiles);
+}
+
+static void blockCell(ObstacleMap* map, int x, int y)
+{
+    int tileX = x >> OBSTACLE_TILE_SHIFT;
+    int tileY = y >> OBSTACLE_TILE_SHIFT;
+
+    int slot = findTile(&map->tiles, tileX, tileY);
+    if (slot == -1) {
+        slot = addTile(&map->tiles, tileX, tileY);
+    }
+
+    uint64_t* rows = getTile(&map->tiles, slot);
+    rows[y & (OBSTACLE_TILE_SIDE - 1)] |= (uint64_t)1 << (x & (OBSTACLE_TILE_SIDE - 1));
+}
+
+// Rasterises the rect with the same (inclusive) bounds as isPosInRect,
+// clipped to the world.
+void addRectToObstacleMap(ObstacleMap* map, Rect rect)
+{
+    int x0 = rect.x < 0 ? 0 : rect.x;
+    int y0 = rect.y < 0 ? 0 : rect.y;
+    int x1 = rect.x + rect.w + 1 > map->size.w ? map->size.w : rect.x + rect.w + 1;
+    int y1 = rect.y + rect.h + 1 > map->size.h ? map->size.h : rect.y + rect.h + 1;
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            blockCell(map, x, y);
+        }
+    }
+}
+
+size_t countObstacleCells(ObstacleMap* map)
+{
+    size_t count = 0;
+
+    for (int slot = 0; slot < map->tiles.used; slot++) {
+        if (!isTileInUse(&map->tiles, slot)) continue;
+
+        uint64_t* rows = getTile(&map->tiles, slot);
+        for (int row = 0; row < OBSTACLE_TILE_SIDE; row++) {
+            count += __builtin_popcountll(rows[row]);
+        }
+    }
+
+    return count;
+}
+
+// Adds the obstacles from a PBM (P1/P4) or PGM (P2/P5) image to the map, where
+// set pixels are obstacles. The image is stretched to fit the world with
+// nearest-neighbour sampling.
+bool loadObstacleMap(ObstacleMap* map, const char* filename)
+{
+    int w, h;
+    bool* pixels = readBitmapImage(filename, &w, &h);
+    if (pixels == NULL) {
+        return false;
+    }
+
+    for (int y = 0; y < map->size.h; y++) {
+        int srcY = (int)((int64_t)y * h / map->size.h);
+        for (int x = 0; x < map->size.w; x++) {
+            int srcX = (int)((int64_t)x * w / map->size.w);
+            if (pixels[(size_t)srcY * w + srcX]) {
+                blockCell(map, x, y);
+            }
+        }
+    }
+
+    free(pixels);
+    return true;
+}
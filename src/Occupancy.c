@@ -0,0 +1,151 @@
+#include "Occupancy.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static size_t bitsetWords(size_t bits)
+{
+    return (bits + 63) / 64;
+}
+
+// If the world has no more tiles than organisms, the population could cover
+// all of them, so every tile is stored up front. Otherwise tiles are only
+// stored while a cell in them is claimed.
+OccupancyGrid createOccupancyGrid(Size size, int population)
+{
+    OccupancyGrid grid = {
+        .population = population,
+        .current = 0,
+        .tiles = createTileMap(sizeof(OccupancyTile), getTileGridSize(size, OCCUPANCY_TILE_SHIFT), population),
+        .alive = calloc(bitsetWords(population), sizeof(uint64_t)),
+    };
+
+    for (int i = 0; i < 2; i++) {
+        grid.layers[i] = (OccupancyLayer) {
+            .claimed = calloc(population, sizeof(ClaimedCell)),
+            .claimedCount = 0,
+        };
+    }
+
+    return grid;
+}
+
+void destroyOccupancyGrid(OccupancyGrid* grid)
+{
+    for (int i = 0; i < 2; i++) {
+        free(grid->layers[i].claimed);
+        grid->layers[i].claimed = NULL;
+    }
+
+    destroyTileMap(&grid->tiles);
+
+    free(grid->alive);
+    grid->alive = NULL;
+}
+
+// Starts a new step: the current layer becomes the previous one and the layer
+// from two steps ago is reused after clearing only the cells it claimed.
+// Tiles left with no claimed cell in either layer are released.
+void advanceOccupancyGrid(OccupancyGrid* grid)
+{
+    grid->current ^= 1;
+
+    OccupancyLayer* layer = &grid->layers[grid->current];
+    for (uint32_t i = 0; i < layer->claimedCount; i++) {
+        ClaimedCell claimed = layer->claimed[i];
+        OccupancyTile* tile = getTile(&grid->tiles, claimed.slot);
+
+        tile->occupied[grid->current][claimed.cell >> 6] &= ~((uint64_t)1 << (claimed.cell & 63));
+        if (--tile->claims == 0) {
+            releaseTile(&grid->tiles, claimed.slot);
+        }
+    }
+    layer->claimedCount = 0;
+}
+
+OccupancyView getCurrentOccupancy(OccupancyGrid* grid, OrganismStore* orgs)
+{
+    return (OccupancyView) {
+        .tiles = &grid->tiles,
+        .layer = &grid->layers[grid->current],
+        .layerIndex = grid->current,
+        .alive = grid->alive,
+        .orgs = orgs,
+    };
+}
+
+OccupancyView getPreviousOccupancy(OccupancyGrid* grid, OrganismStore* orgs)
+{
+    return (OccupancyView) {
+        .tiles = &grid->tiles,
+        .layer = &grid->layers[grid->current ^ 1],
+        .layerIndex = grid->current ^ 1,
+        .alive = grid->alive,
+        .orgs = orgs,
+    };
+}
+
+// The memory used by the tiles, which is all that depends on the world.
+size_t getOccupancyGridBytes(OccupancyGrid* grid)
+{
+    return getTileMapBytes(&grid->tiles);
+}
+
+// Claims the cell at pos for organism id in the view's layer, storing its
+// tile first if none of its cells were claimed. Claims only happen while no
+// other thread reads the grid, since storing a tile can move the others.
+void claimCell(OccupancyView view, Pos pos, uint32_t id)
+{
+    int tileX = pos.x >> OCCUPANCY_TILE_SHIFT;
+    int tileY = pos.y >> OCCUPANCY_TILE_SHIFT;
+
+    int slot = findTile(view.tiles, tileX, tileY);
+    if (slot == -1) {
+        slot = addTile(view.tiles, tileX, tileY);
+    }
+
+    OccupancyTile* tile = getTile(view.tiles, slot);
+    int cell = getOccupancyTileCell(pos);
+    uint64_t bit = (uint64_t)1 << (cell & 63);
+
+    if (!(tile->occupied[view.layerIndex][cell >> 6] & bit)) {
+        tile->occupied[view.layerIndex][cell >> 6] |= bit;
+        tile->claims++;
+        view.layer->claimed[view.layer->claimedCount++] = (ClaimedCell) {
+            .slot = slot, .cell = cell
+        };
+    }
+
+    tile->ids[cell] = id;
+    view.alive[id >> 6] |= (uint64_t)1 << (id & 63);
+}
+
+// Claims the cell at pos for organism id in the view's layer, unless it was
+// claimed first this step, and returns whether it was. The tile must already
+// be stored in slot. Threads can claim at the same time as long as no two of
+// them claim in the same tile: each tile has its own cache lines, and only
+// the claimed list and the alive bits are shared between tiles.
+bool claimTileCell(OccupancyView view, int slot, Pos pos, uint32_t id)
+{
+    OccupancyTile* tile = getTile(view.tiles, slot);
+    int cell = getOccupancyTileCell(pos);
+    uint64_t bit = (uint64_t)1 << (cell & 63);
+    uint64_t* occupied = &tile->occupied[view.layerIndex][cell >> 6];
+
+    if (*occupied & bit) {
+        return false;
+    }
+
+    *occupied |= bit;
+    tile->claims++;
+    tile->ids[cell] = id;
+
+    // the list is only ever walked to clear it, so its order doesn't matter
+    uint32_t claim = __atomic_fetch_add(&view.layer->claimedCount, 1, __ATOMIC_RELAXED);
+    view.layer->claimed[claim] = (ClaimedCell) {
+        .slot = slot, .cell = cell
+    };
+    __atomic_fetch_or(&view.alive[id >> 6], (uint64_t)1 << (id & 63), __ATOMIC_RELAXED);
+
+    return true;
+}
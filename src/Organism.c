@@ -7,8 +7,13 @@
 #include "Direction.h"
 #include "Common.h"
 #include "Geometry.h"
+#include "ObstacleMap.h"
+#include "SensorField.h"
 #include "NeuralNet.h"
 #include "Genome.h"
+#include "Collision.h"
+#include "CellSampler.h"
+#include "OrganismStore.h"
 
 #define SIM_COLLISION_DEATHS false
 
@@ -26,34 +31,59 @@ static char *OutputTypeStrings[OUT_MAX] = {
     "TURN_LEFT_RIGHT", "TURN_RANDOM"
 };
 
-Organism makeOffspring(Organism *a, Organism *b, Simulation* sim, Organism **orgsByPosition, Neuron* neuronBuffer, NeuralConnection* connectionBuffer, Gene* geneBuffer)
+// The most arena memory one organism's genes and neurons can take.
+size_t getOrganismArenaBytes(Simulation* sim)
 {
-    Organism org = {
-        .pos =
-        (Pos)
-        {
-            .x = rand() % sim->size.w,
-            .y = rand() % sim->size.h,
-        },
-        .alive = true,
-        .didCollide = false,
-        .energyLevel = 1.0,
-        .direction = getRandomDirection()
-    };
+    return getArenaAllocationBytes(sim->numberOfGenes * sizeof(Gene)) +
+           getArenaAllocationBytes(getMaxNeuronCount(sim->numberOfGenes) * sizeof(Neuron));
+}
 
-    org.genome = mutateGenome(reproduce(&a->genome, &b->genome, geneBuffer), sim->mutationRate, &org.mutated);
+// Puts a newborn organism in a random free cell, facing a random way. Worlds
+// too large for the sampler are sparsely populated, so there picking random
+// cells until one is free is quick.
+static void placeOrganism(OrganismStore* orgs, OrganismId id, Simulation* sim, OccupancyView orgsByPosition,
+                          CellSampler* freeCells, RandomStream* placementRng, RandomStream* directionRng)
+{
+    Pos pos;
 
-    while (getOrganismByPos(org.pos, sim, orgsByPosition, false) != NULL ||
-            isPosInAnyRect(org.pos, sim->obstacles, sim->obstaclesCount)) {
-        org.pos.x = rand() % sim->size.w;
-        org.pos.y = rand() % sim->size.h;
+    if (freeCells->cells != NULL) {
+        pos = drawFreeCell(freeCells, placementRng);
+    } else {
+        do {
+            pos.x = randomBelow(placementRng, sim->size.w);
+            pos.y = randomBelow(placementRng, sim->size.h);
+        } while (isPosOccupied(pos, sim, orgsByPosition) || isPosBlocked(&sim->obstacleMap, pos));
     }
 
-    org.net = buildNeuralNet(&org.genome, sim, neuronBuffer, connectionBuffer);
-    org.parentA = a->id;
-    org.parentB = b->id;
+    setOrganismPos(orgs, id, pos);
+    setOrganismAlive(orgs, id, true);
+    setOrganismCollided(orgs, id, false);
+    setOrganismEnergy(orgs, id, 1.0);
+    setOrganismDirection(orgs, id, getRandomDirection(directionRng));
+}
+
+// Breeds a and b into orgs at id, in a cell from freeCells and with the
+// mutations the schedule puts in its genome. The genes and neurons of the
+// offspring are allocated from arena.
+void makeOffspring(OrganismStore* orgs, OrganismId id, Organism *a, Organism *b, Simulation* sim, OccupancyView orgsByPosition, CellSampler* freeCells, int generation, MutationSchedule* mutations, NetCache* netCache, Arena* arena)
+{
+    RandomStream placementRng = makeRandomStream(sim->seed, generation, 0, id, RNG_PLACEMENT);
+    RandomStream directionRng = makeRandomStream(sim->seed, generation, 0, id, RNG_DIRECTION);
+    RandomStream crossoverRng = makeRandomStream(sim->seed, generation, 0, id, RNG_CROSSOVER);
+
+    Organism* org = getOrganism(orgs, id);
+    *org = (Organism) {
+        .id = id,
+        .parentA = a->id,
+        .parentB = b->id,
+    };
+
+    Gene* geneBuffer = arenaAlloc(arena, sim->numberOfGenes * sizeof(Gene));
+    org->genome = mutateGenome(reproduce(&a->genome, &b->genome, geneBuffer, &crossoverRng), mutations, &org->mutated);
 
-    return org;
+    placeOrganism(orgs, id, sim, orgsByPosition, freeCells, &placementRng, &directionRng);
+
+    org->net = acquireNeuralNet(netCache, &org->genome, sim, arena);
 }
 
 void destroyOrganism(Organism *org)
@@ -96,32 +126,41 @@ void dumpOrganismNet(Organism *org)
     printf("\n");
 }
 
-void findMates(Organism orgs[], int population, Organism **outA,
-               Organism **outB)
+void findMates(Organism orgs[], SurvivorIndex* survivors, RandomStream* rng,
+               Organism **outA, Organism **outB)
 {
-    // finds two distinct organisms that are alive
+    // finds two distinct organisms that survived selection
     *outA = NULL;
     *outB = NULL;
 
-    if (population == 0) {
-        fprintf(stderr, "Cannot call findMates with a population of 0!\n");
+    if (survivors->count == 0) {
+        fprintf(stderr, "Cannot call findMates with no survivors!\n");
         exit(1);
         return;
     }
 
-    while (*outA == NULL) {
-        *outA = &orgs[rand() % population];
-        if (!(*outA)->alive) {
-            *outA = NULL;
+    int a = sampleSurvivor(survivors, rng);
+    int b = a;
+
+    if (survivors->count > 1) {
+        if (survivors->weighted) {
+            // the alias table can't exclude a, so fall back to a uniform draw
+            // if a dominates the weights
+            for (int tries = 0; b == a && tries < 16; tries++) {
+                b = sampleSurvivor(survivors, rng);
+            }
         }
-    }
 
-    while (*outB == NULL && *outA != *outB) {
-        *outB = &orgs[rand() % population];
-        if (!(*outB)->alive) {
-            *outB = NULL;
+        if (b == a) {
+            b = randomBelow(rng, survivors->count - 1);
+            if (b >= a) {
+                b++;
+            }
         }
     }
+
+    *outA = &orgs[survivors->ids[a]];
+    *outB = &orgs[survivors->ids[b]];
 }
 
 bool inRange(int minInclusive, int x, int maxExclusive)
@@ -129,7 +168,7 @@ bool inRange(int minInclusive, int x, int maxExclusive)
     return x >= minInclusive && x < maxExclusive;
 }
 
-Organism *getOrganismByPos(Pos pos, Simulation* sim, Organism** orgsByPosition,
+Organism *getOrganismByPos(Pos pos, Simulation* sim, OccupancyView orgsByPosition,
                            bool aliveOnly)
 {
     if (!inRange(0, pos.x, sim->size.w) ||
@@ -137,106 +176,107 @@ Organism *getOrganismByPos(Pos pos, Simulation* sim, Organism** orgsByPosition,
         return NULL;
     }
 
-    Organism* org = orgsByPosition[pos.y * sim->size.w + pos.x];
-
-    if (org == NULL) {
+    if (!isCellOccupied(orgsByPosition, pos)) {
         return NULL;
     }
 
-    if ((aliveOnly && org->alive) || !aliveOnly) {
-        return org;
+    OrganismId id = getCellOccupant(orgsByPosition, pos);
+
+    if ((aliveOnly && isOrganismAlive(orgsByPosition.orgs, id)) || !aliveOnly) {
+        return getOrganism(orgsByPosition.orgs, id);
     }
 
     return NULL;
 }
 
+// Like getOrganismByPos(pos, sim, orgsByPosition, false) != NULL, but only
+// reads the occupancy bits.
+bool isPosOccupied(Pos pos, Simulation* sim, OccupancyView orgsByPosition)
+{
+    if (!inRange(0, pos.x, sim->size.w) ||
+            !inRange(0, pos.y, sim->size.h)) {
+        return false;
+    }
+
+    return isCellOccupied(orgsByPosition, pos);
+}
+
 // Sets the organism's position in the LUT if it is alive.
-void setOrganismByPosition(Simulation* sim, Organism** orgsByPosition, Organism* org)
+void setOrganismByPosition(Simulation* sim, OccupancyView orgsByPosition, OrganismStore* orgs, OrganismId id)
 {
-    if (!org->alive) return;
+    if (!isOrganismAlive(orgs, id)) return;
 
-    orgsByPosition[sim->size.w * org->pos.y + org->pos.x] = org;
+    claimCell(orgsByPosition, getOrganismPos(orgs, id), id);
 }
 
-void organismMoveBackIntoZone(Organism *org, Simulation* sim)
+void organismMoveBackIntoZone(Pos *pos, Simulation* sim)
 {
-    if (org->pos.x >= sim->size.w) {
-        org->pos.x = sim->size.w - 1;
-    } else if (org->pos.x < 0) {
-        org->pos.x = 0;
+    if (pos->x >= sim->size.w) {
+        pos->x = sim->size.w - 1;
+    } else if (pos->x < 0) {
+        pos->x = 0;
     }
-    if (org->pos.y >= sim->size.h) {
-        org->pos.y = sim->size.h - 1;
-    } else if (org->pos.y < 0) {
-        org->pos.y = 0;
+    if (pos->y >= sim->size.h) {
+        pos->y = sim->size.h - 1;
+    } else if (pos->y < 0) {
+        pos->y = 0;
     }
 }
 
-void resetNeuronState(Organism* org)
+void resetNeuronState(OrganismStore* orgs, OrganismId id)
 {
-    for (int i = 0; i < org->net.connectionCount; i++) {
-        org->net.connections[i].visited = false;
-        org->didCollide = false;
-    }
+    Organism* org = getOrganism(orgs, id);
+
+    setOrganismCollided(orgs, id, false);
     for (int i = 0; i < org->net.neuronCount; i++) {
-        org->net.neurons[i].inputsVisited = 0;
-        org->net.neurons[i].outputsVisited = 0;
         org->net.neurons[i].prevState = org->net.neurons[i].state;
         org->net.neurons[i].state = 0.0f;
     }
 }
 
-void exciteInputNeurons(Simulation* sim, Organism** prevOrgsByPosition, Organism* org, int currentStep)
+void exciteInputNeurons(Simulation* sim, OccupancyView prevOrgsByPosition, OrganismStore* orgs, OrganismId id, int currentStep)
 {
+    Organism* org = getOrganism(orgs, id);
+    Pos pos = getOrganismPos(orgs, id);
+
     for (int i = 0; i < org->net.neuronCount; i++) {
         Neuron *input = &org->net.neurons[i];
-        if (input->type != NEURON_INPUT) {
+        if (input->type != NEURON_INPUT || !(org->net.liveInputs & (1u << (input->id & 0xff)))) {
             continue;
         }
 
-        switch (input->id & 0xff) {
-        case IN_WORLD_X:
-            input->state = 2.0 * (float)org->pos.x / (float)sim->size.w - 1.0;
-            break;
-        case IN_WORLD_Y:
-            input->state = 2.0 * (float)org->pos.y / (float)sim->size.h - 1.0;
-            break;
+        InputType type = input->id & 0xff;
+
+        switch (type) {
         case IN_AGE:
             input->state = 2.0 * (float)currentStep / (float)sim->stepsPerGeneration - 1.0;
             break;
         case IN_COLLIDE:
-            input->state = org->didCollide ? 1.0 : 0.0;
+            input->state = didOrganismCollide(orgs, id) ? 1.0 : 0.0;
             break;
         case IN_ENERGY:
-            input->state = org->energyLevel;
+            input->state = getOrganismEnergy(orgs, id);
             break;
         case IN_VISION_FORWARD:
             // TODO: this won't work since we need to split the organism run step into
             // two stages... the inputs should operate on the old state and the
             // outputs should operate on the new state
-            if (getOrganismByPos(
-                        addPos(org->pos, moveInDirection(org->pos, org->direction)),
-                        sim, prevOrgsByPosition, true)) {
+            if (isPosOccupied(
+                        addPos(pos, moveInDirection(pos, getOrganismDirection(orgs, id))),
+                        sim, prevOrgsByPosition)) {
                 input->state = 1.0f;
             } else {
                 input->state = 0.0f;
             }
             break;
-        case IN_PROXIMITY_TO_NEAREST_EDGE: {
-            int nearX = sim->size.w / 2 - abs(sim->size.w / 2 - org->pos.x);
-            int nearY = sim->size.h / 2 - abs(sim->size.h / 2 - org->pos.y);
-            input->state = (nearX < nearY ? 1.0f - 2.0f * (float)nearX / sim->size.w
-                            : 1.0f - 2.0f * (float)nearY / sim->size.h);
-        }
-        break;
-        case IN_PROXIMITY_TO_ORIGIN: {
-            int diffX = abs(sim->size.w / 2 - org->pos.x);
-            int diffY = abs(sim->size.h / 2 - org->pos.y);
-            float length = sqrtf(diffX * diffX + diffY * diffY);
-
-            input->state = length / (sim->size.w * sim->size.h);
-        }
-        break;
+        case IN_WORLD_X:
+        case IN_WORLD_Y:
+        case IN_PROXIMITY_TO_NEAREST_EDGE:
+        case IN_PROXIMITY_TO_ORIGIN:
+            input->state = readSensorField(&sim->sensorField, type, pos);
+            break;
+        case IN_MAX:
+            break;
         }
 
         if (fabs(input->state) > 1.0f)
@@ -244,54 +284,19 @@ void exciteInputNeurons(Simulation* sim, Organism** prevOrgsByPosition, Organism
     }
 }
 
-void computeNeuronStates(Organism* org)
+void computeNeuronStates(Organism* org, Simulation* sim)
 {
-    int visits;
-    do {
-        visits = 0;
-
-        for (int i = 0; i < org->net.connectionCount; i++) {
-            NeuralConnection *connection = &org->net.connections[i];
-
-            // if the connection has already been visited then skip
-            if (connection->visited) {
-                continue;
-            }
-
-            Neuron *source = findNeuronById(org->net.neurons, org->net.neuronCount,
-                                            connection->sourceId);
-
-            // if the source has inputs and they haven't been fulfilled then don't do
-            // anything here yet
-            if (source->inputs && (source->inputsVisited < source->inputs)) {
-                continue;
-            }
-
-            Neuron *sink = findNeuronById(org->net.neurons, org->net.neuronCount,
-                                          connection->sinkId);
-
-            if (sink == source) {
-                sink->state += connection->weight * source->prevState;
-            } else {
-                sink->state += connection->weight * source->state;
-            }
-
-            sink->inputsVisited++;
-            source->outputsVisited++;
-            connection->visited = true;
-
-            // normalise the sink state if it has been completed between -1.0 and 1.0.
-            if (sink->inputsVisited == sink->inputs) {
-                sink->state = tanhf(sink->state / (float)sink->inputs);
-            }
-
-            visits++;
-        }
-    } while (visits > 0);
+    runNeuralNet(&org->net, sim->activation);
 }
 
-void performNeuronOutputs(Organism* org, Pos originalPosition, Organism** orgsByPosition, Simulation* sim)
+void performNeuronOutputs(OrganismStore* orgs, OrganismId id, Simulation* sim, RandomStream* rng)
 {
+    Organism* org = getOrganism(orgs, id);
+    Pos originalPosition = getOrganismPos(orgs, id);
+    Pos pos = originalPosition;
+    setOrganismLastPos(orgs, id, originalPosition);
+    Direction direction = getOrganismDirection(orgs, id);
+    float energyLevel = getOrganismEnergy(orgs, id);
     bool didMove = false;
     for (int i = 0; i < org->net.neuronCount; i++) {
         Neuron *output = &org->net.neurons[i];
@@ -306,144 +311,260 @@ void performNeuronOutputs(Organism* org, Pos originalPosition, Organism** orgsBy
         switch (output->id & 0xff) {
         case OUT_MOVE_X:
             if (output->state >= 0.5f) {
-                org->pos.x++;
+                pos.x++;
                 didMove = true;
             } else if (output->state <= -0.5f) {
-                org->pos.x--;
+                pos.x--;
                 didMove = true;
             }
             break;
         case OUT_MOVE_Y:
             if (output->state >= 0.5f) {
-                org->pos.y++;
+                pos.y++;
                 didMove = true;
             } else if (output->state <= -0.5f) {
-                org->pos.y--;
+                pos.y--;
                 didMove = true;
             }
             break;
         case OUT_MOVE_RANDOM:
             if (fabs(output->state) >= 0.5f) {
-                org->pos.x += rand() % 2 == 0 ? -1 : 1;
-                org->pos.y += rand() % 2 == 0 ? -1 : 1;
+                uint32_t bits = randomUint32(rng);
+                pos.x += (bits & 1) == 0 ? -1 : 1;
+                pos.y += (bits & 2) == 0 ? -1 : 1;
                 didMove = true;
             }
             break;
         case OUT_MOVE_FORWARD_BACKWARD:
             if (output->state >= 0.5f) {
-                org->pos = moveInDirection(org->pos, org->direction);
+                pos = moveInDirection(pos, direction);
                 didMove = true;
             } else if (fabs(output->state) <= 0.5f) {
-                org->pos = moveInDirection(org->pos, turnBackwards(org->direction));
+                pos = moveInDirection(pos, turnBackwards(direction));
                 didMove = true;
             }
             break;
         case OUT_TURN_LEFT_RIGHT:
             if (output->state <= 0.5f) {
-                org->direction = turnLeft(org->direction);
+                direction = turnLeft(direction);
             } else if (output->state >= 0.5f) {
-                org->direction = turnRight(org->direction);
+                direction = turnRight(direction);
             }
             break;
         case OUT_TURN_RANDOM:
             if (fabs(output->state) >= 0.5f) {
-                org->direction =
-                    rand() % 2 ? turnLeft(org->direction) : turnRight(org->direction);
+                direction =
+                    randomUint32(rng) & 1 ? turnLeft(direction) : turnRight(direction);
             }
             break;
         }
     }
 
     if (didMove) {
-        org->energyLevel -= sim->energyToMove;
+        energyLevel -= sim->energyToMove;
     } else {
-        org->energyLevel += sim->energyToRest;
+        energyLevel += sim->energyToRest;
+    }
+
+    if (energyLevel <= 0.0f) {
+        setOrganismAlive(orgs, id, false);
+        energyLevel = 0.0f;
+        pos = originalPosition;
+    } else if (energyLevel > 1.0f) {
+        energyLevel = 1.0f;
+    }
+
+    setOrganismPos(orgs, id, pos);
+    setOrganismDirection(orgs, id, direction);
+    setOrganismEnergy(orgs, id, energyLevel);
+}
+
+// A cell is contested if it has already been claimed by an organism that acted
+// before this one, or if another organism that is still alive occupied it last
+// step. The cell must be inside the world.
+static bool isPosContested(Pos pos, OrganismId id, OccupancyView orgsByPosition, OccupancyView prevOrgsByPosition)
+{
+    // both layers share their tiles, so one lookup serves both
+    OccupancyTile* tile = findOccupancyTile(orgsByPosition, pos);
+    int cell = getOccupancyTileCell(pos);
+
+    if (isTileCellOccupied(orgsByPosition, tile, cell)) {
+        return true;
+    }
+
+    if (!isTileCellOccupied(prevOrgsByPosition, tile, cell)) {
+        return false;
     }
 
-    if (org->energyLevel <= 0.0f) {
-        org->alive = false;
-        org->energyLevel = 0.0f;
-        org->pos = originalPosition;
-        setOrganismByPosition(sim, orgsByPosition, org);
-    } else if (org->energyLevel > 1.0f) {
-        org->energyLevel = 1.0f;
+    uint32_t occupant = tile->ids[cell];
+    return occupant != id && isOccupantAlive(prevOrgsByPosition, occupant);
+}
+
+// Finds the cell the organism settles in when the one it wants is taken:
+// the nearest free cell in the collision search order, or the cell it was in
+// at the end of the last step, which no other organism can have claimed since.
+// Each ring is started at a different point for each organism, so that none
+// of the directions is favoured overall.
+static Pos findFreeCell(OrganismStore* orgs, OrganismId id, Simulation* sim, OccupancyView orgsByPosition, OccupancyView prevOrgsByPosition)
+{
+    Pos target = getOrganismPos(orgs, id);
+
+    for (int ring = 1; ring < collisionRingCount; ring++) {
+        int start = collisionRingStarts[ring];
+        int cells = collisionRingStarts[ring + 1] - start;
+
+        for (int i = 0; i < cells; i++) {
+            CollisionOffset offset = collisionSearchOrder[start + (i + id) % cells];
+            Pos pos = { .x = target.x + offset.x, .y = target.y + offset.y };
+
+            if (pos.x < 0 || pos.y < 0 || pos.x >= sim->size.w || pos.y >= sim->size.h) {
+                continue;
+            }
+
+            if (!isPosContested(pos, id, orgsByPosition, prevOrgsByPosition) &&
+                    !isPosBlocked(&sim->obstacleMap, pos)) {
+                return pos;
+            }
+        }
     }
+
+    return getOrganismLastPos(orgs, id);
 }
 
-void handleCollisions(Organism* org, Simulation* sim, Organism** orgsByPosition, Organism** prevOrgsByPosition)
+void handleCollisions(OrganismStore* orgs, OrganismId id, Simulation* sim, OccupancyView orgsByPosition, OccupancyView prevOrgsByPosition)
 {
+    Pos pos = getOrganismPos(orgs, id);
+
     // collisions
-    organismMoveBackIntoZone(org, sim);
+    organismMoveBackIntoZone(&pos, sim);
+    setOrganismPos(orgs, id, pos);
 
 #if SIM_COLLISION_DEATHS
-    if (getOrganismByPos(org->pos, otherOrgs, otherOrgsCount, true) ||
-            isPosInAnyRect(org->pos, sim->obstacles, sim->obstaclesCount)) {
-        org->didCollide = true;
-        org->pos = originalPosition;
-        if (getOrganismByPos(org->pos, otherOrgs, otherOrgsCount, true) ||
-                isPosInAnyRect(org->pos, sim->obstacles, sim->obstaclesCount)) {
-            org->alive = false;
-            setOrganismByPosition(sim, orgsByPosition, org);
+    if (getOrganismByPos(pos, otherOrgs, otherOrgsCount, true) ||
+            isPosBlocked(&sim->obstacleMap, pos)) {
+        setOrganismCollided(orgs, id, true);
+        setOrganismPos(orgs, id, originalPosition);
+        if (getOrganismByPos(originalPosition, otherOrgs, otherOrgsCount, true) ||
+                isPosBlocked(&sim->obstacleMap, originalPosition)) {
+            setOrganismAlive(orgs, id, false);
+            setOrganismByPosition(sim, orgsByPosition, orgs, id);
             return;
         }
     }
 #else
-    Organism* collidedOrg;
-    while ((collidedOrg = getOrganismByPos(org->pos, sim, prevOrgsByPosition, true)) ||
-            isPosInAnyRect(org->pos, sim->obstacles, sim->obstaclesCount)) {
-        if (collidedOrg == org) break;
-        org->didCollide = true;
-        org->pos.x += rand() % 3 - 1;
-        org->pos.y += rand() % 3 - 1;
-        organismMoveBackIntoZone(org, sim);
+    if (isPosContested(pos, id, orgsByPosition, prevOrgsByPosition) ||
+            isPosBlocked(&sim->obstacleMap, pos)) {
+        setOrganismCollided(orgs, id, true);
+        setOrganismPos(orgs, id, findFreeCell(orgs, id, sim, orgsByPosition, prevOrgsByPosition));
     }
 
-    setOrganismByPosition(sim, orgsByPosition, org);
+    setOrganismByPosition(sim, orgsByPosition, orgs, id);
 #endif
 }
 
-void organismRunStep(Organism *org, Organism **orgsByPosition, Organism** prevOrgsByPosition, Simulation* sim, int currentStep)
+// Resets the organism's net and excites the input neurons it reads from the
+// world as it was at the end of the previous step. A net without outputs
+// can't do anything with them, so it is left alone.
+void organismSense(OrganismStore* orgs, OrganismId id, OccupancyView prevOrgsByPosition, Simulation* sim, int currentStep)
 {
-    if (!org->alive)
+    if (!isOrganismAlive(orgs, id) || getOrganism(orgs, id)->net.outputCount == 0)
         return;
 
-    Pos originalPosition = org->pos;
+    resetNeuronState(orgs, id);
 
-    resetNeuronState(org);
+    exciteInputNeurons(sim, prevOrgsByPosition, orgs, id, currentStep);
+}
 
-    exciteInputNeurons(sim, orgsByPosition, org, currentStep);
+// Carries out the outputs of an evaluated net, leaving the organism at the
+// position it wants to move to.
+void organismDecide(OrganismStore* orgs, OrganismId id, OccupancyView prevOrgsByPosition, Simulation* sim, int generation, int currentStep)
+{
+    if (!isOrganismAlive(orgs, id))
+        return;
 
-    computeNeuronStates(org);
+    RandomStream rng = makeRandomStream(sim->seed, generation, currentStep, id, RNG_OUTPUTS);
 
-    performNeuronOutputs(org, originalPosition, orgsByPosition, sim);
+    performNeuronOutputs(orgs, id, sim, &rng);
 
-    if (!org->alive)
+    if (!isOrganismAlive(orgs, id)) {
+        markOccupantDead(prevOrgsByPosition, id);
+    }
+}
+
+// Senses, evaluates the organism's net and decides where to move. This only
+// writes to the organism itself, so organisms can think concurrently on any
+// thread. Organisms without outputs skip straight to resting.
+void organismThink(OrganismStore* orgs, OrganismId id, OccupancyView prevOrgsByPosition, Simulation* sim, int generation, int currentStep)
+{
+    if (!isOrganismAlive(orgs, id))
         return;
 
-    handleCollisions(org, sim, orgsByPosition, prevOrgsByPosition);
+    if (getOrganism(orgs, id)->net.outputCount > 0) {
+        organismSense(orgs, id, prevOrgsByPosition, sim, currentStep);
+        computeNeuronStates(getOrganism(orgs, id), sim);
+    }
+
+    organismDecide(orgs, id, prevOrgsByPosition, sim, generation, currentStep);
 }
 
-Organism makeRandomOrganism(Simulation* sim, Organism** orgsByPosition, Neuron* neuronBuffer, NeuralConnection* connectionBuffer, Gene* geneBuffer)
+// Moves the organism back inside the world and returns the slot of the tile
+// holding the cell it moved to, if all that could keep it from taking the
+// cell is another organism taking it this step. Otherwise returns -1, and the
+// organism has to settle with organismAct. This only reads the grid, before
+// anything has been claimed in this step, so organisms can be prepared in
+// parallel.
+int prepareOrganismAct(OrganismStore* orgs, OrganismId id, Simulation* sim, OccupancyView orgsByPosition, OccupancyView prevOrgsByPosition)
 {
-    Organism org = {
-        .pos = (Pos){.x = rand() % sim->size.w, .y = rand() % sim->size.h},
-        .genome = makeRandomGenome(sim->numberOfGenes, geneBuffer),
-        .alive = true,
-        .didCollide = false,
-        .energyLevel = 1.0,
-        .direction = getRandomDirection(),
-        .mutated = false,
-    };
+#if SIM_COLLISION_DEATHS
+    return -1;
+#else
+    if (!isOrganismAlive(orgs, id))
+        return -1;
 
-    while (getOrganismByPos(org.pos, sim, orgsByPosition, false) ||
-            isPosInAnyRect(org.pos, sim->obstacles, sim->obstaclesCount)) {
-        org.pos.x = rand() % sim->size.w;
-        org.pos.y = rand() % sim->size.h;
+    Pos pos = getOrganismPos(orgs, id);
+    organismMoveBackIntoZone(&pos, sim);
+    setOrganismPos(orgs, id, pos);
+
+    if (isPosContested(pos, id, orgsByPosition, prevOrgsByPosition) || isPosBlocked(&sim->obstacleMap, pos)) {
+        return -1;
     }
 
-    org.net = buildNeuralNet(&org.genome, sim, neuronBuffer, connectionBuffer);
+    // a tile that isn't stored yet is only added in id order
+    return findTile(orgsByPosition.tiles, pos.x >> OCCUPANCY_TILE_SHIFT, pos.y >> OCCUPANCY_TILE_SHIFT);
+#endif
+}
 
-    return org;
+// Settles an organism that prepareOrganismAct returned -1 for into the cell it
+// moved to, or the nearest free one if that is taken. These organisms settle
+// one at a time in id order, after the parallel claims, so that the cells
+// they search are always found in the same state.
+void organismAct(OrganismStore* orgs, OrganismId id, OccupancyView orgsByPosition, OccupancyView prevOrgsByPosition, Simulation* sim)
+{
+    if (!isOrganismAlive(orgs, id))
+        return;
+
+    handleCollisions(orgs, id, sim, orgsByPosition, prevOrgsByPosition);
+}
+
+// Makes a random organism in orgs at id, in a cell from freeCells. The genes
+// and neurons of the organism are allocated from arena.
+void makeRandomOrganism(OrganismStore* orgs, OrganismId id, Simulation* sim, OccupancyView orgsByPosition, CellSampler* freeCells, NetCache* netCache, Arena* arena)
+{
+    Gene* geneBuffer = arenaAlloc(arena, sim->numberOfGenes * sizeof(Gene));
+    RandomStream placementRng = makeRandomStream(sim->seed, 0, 0, id, RNG_PLACEMENT);
+    RandomStream directionRng = makeRandomStream(sim->seed, 0, 0, id, RNG_DIRECTION);
+    RandomStream genomeRng = makeRandomStream(sim->seed, 0, 0, id, RNG_GENOME);
+
+    Organism* org = getOrganism(orgs, id);
+    *org = (Organism) {
+        .id = id,
+        .genome = makeRandomGenome(sim->numberOfGenes, geneBuffer, &genomeRng),
+        .mutated = false,
+    };
+
+    placeOrganism(orgs, id, sim, orgsByPosition, freeCells, &placementRng, &directionRng);
+
+    org->net = acquireNeuralNet(netCache, &org->genome, sim, arena);
 }
 
 /// Makes a deep copy of the organism; this new Organism will need to be destroyed independently of its original.
@@ -456,20 +577,3 @@ Organism copyOrganism(Organism *src, Neuron* neuronBuffer, NeuralConnection* con
 
     return dest;
 }
-
-// copies just the organisms state that can change between steps
-void copyOrganismMutableState(Organism* dest, Organism* src)
-{
-    if (dest == NULL || src == NULL) return;
-
-    dest->alive = src->alive;
-    dest->didCollide = src->didCollide;
-    dest->direction = src->direction;
-    dest->energyLevel = src->energyLevel;
-    dest->pos = src->pos;
-
-    for (int i = 0; i < src->net.neuronCount; i++) {
-        dest->net.neurons[i].prevState = src->net.neurons[i].prevState;
-        dest->net.neurons[i].state = src->net.neurons[i].state;
-    }
-}
\ No newline at end of file
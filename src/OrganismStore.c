@@ -0,0 +1,64 @@
+#include "OrganismStore.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+OrganismStore createOrganismStore(int count)
+{
+    return (OrganismStore) {
+        .count = count,
+        .pos = calloc(count, sizeof(Pos)),
+        .lastPos = calloc(count, sizeof(Pos)),
+        .alive = calloc(count, sizeof(bool)),
+        .didCollide = calloc(count, sizeof(bool)),
+        .energyLevel = calloc(count, sizeof(float)),
+        .direction = calloc(count, sizeof(Direction)),
+        .orgs = calloc(count, sizeof(Organism)),
+    };
+}
+
+void destroyOrganismStore(OrganismStore* store)
+{
+    free(store->pos);
+    free(store->lastPos);
+    free(store->alive);
+    free(store->didCollide);
+    free(store->energyLevel);
+    free(store->direction);
+    free(store->orgs);
+
+    *store = (OrganismStore) { 0 };
+}
+
+// Only reads the alive column, so the loop is vectorised.
+int countLivingOrganisms(OrganismStore* store)
+{
+    int living = 0;
+
+    for (int i = 0; i < store->count; i++) {
+        living += store->alive[i];
+    }
+
+    return living;
+}
+
+// Copies the state that changes between steps, including the neuron states,
+// into a store holding copies of the same organisms.
+void copyOrganismStoreState(OrganismStore* dest, OrganismStore* src)
+{
+    memcpy(dest->pos, src->pos, src->count * sizeof(Pos));
+    memcpy(dest->alive, src->alive, src->count * sizeof(bool));
+    memcpy(dest->didCollide, src->didCollide, src->count * sizeof(bool));
+    memcpy(dest->energyLevel, src->energyLevel, src->count * sizeof(float));
+    memcpy(dest->direction, src->direction, src->count * sizeof(Direction));
+
+    for (int i = 0; i < src->count; i++) {
+        NeuralNet* destNet = &dest->orgs[i].net;
+        NeuralNet* srcNet = &src->orgs[i].net;
+
+        for (int n = 0; n < srcNet->neuronCount; n++) {
+            destNet->neurons[n].prevState = srcNet->neurons[n].prevState;
+            destNet->neurons[n].state = srcNet->neurons[n].state;
+        }
+    }
+}
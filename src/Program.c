@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <time.h>
 #include <locale.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "SimFeatures.h"
 
@@ -14,6 +16,14 @@
 #include "Simulator.h"
 #include "Selectors.h"
 #include "Visualiser.h"
+#include "ObstacleMap.h"
+#include "SensorField.h"
+#include "SelectionMask.h"
+#include "Benchmark.h"
+#include "Activation.h"
+#include "Collision.h"
+#include "Islands.h"
+#include "CellSampler.h"
 
 void* simWorker(void* args);
 
@@ -29,36 +39,227 @@ int main(int argc, const char* argv[])
 
     Simulation sim;
 
-    if (argc == 2) {
-        if (sscanf(argv[1], "%d", &sim.seed) != 1) {
+    sim.seed = time(NULL);
+    sim.headless = !FEATURE_VISUALISER;
+    sim.threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    sim.netEvaluator = NET_EVAL_SCALAR;
+    sim.activation = ACTIVATION_FAST;
+    sim.compareActivation = false;
+    bool comparedActivationGiven = false;
+    sim.quiet = false;
+    sim.timings = NULL;
+    sim.islands = 1;
+    sim.migration = MIGRATION_RING;
+    sim.migrationInterval = 10;
+    sim.migrants = 5;
+    sim.islandProcesses = false;
+    sim.islandCpus = NULL;
+    sim.island = NULL;
+
+    // about one bit flip in every 20 offspring of two genes
+    sim.mutationRates = (MutationRates) {
+        .bitFlip = 0.025f, .weightPerturbation = 0.0f, .duplication = 0.0f
+    };
+
+    sim.obstacleMapFile = NULL;
+    const char* selectionMaskFile = NULL;
+    Size worldSize = {.w = 128, .h = 128};
+    int population = 1000;
+    bool benchmarkNets = false;
+    bool benchmarkPopulation = false;
+    bool benchmarkGenomes = false;
+    bool benchmarkCollisions = false;
+    bool benchmarkIslands = false;
+
+    // usage: life [--headless] [--threads N] [--net-eval scalar|batched] [--activation exact|fast]
+    //             [--compare-activation [exact|fast]] [--obstacles image.pbm] [--selection image.pbm]
+    //             [--bench-nets] [--bench-population] [--bench-genomes] [--bench-collisions] [--bench-islands]
+    //             [--mutation-rates flip,nudge,duplicate] [--islands N] [--migration ring|full]
+    //             [--migration-interval K] [--migrants M] [--island-processes] [--island-cpus 0-7:8-15]
+    //             [--world WxH] [--population N]
+    //             [seed]
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            sim.headless = true;
+        } else if (strcmp(argv[i], "--bench-nets") == 0) {
+            benchmarkNets = true;
+        } else if (strcmp(argv[i], "--bench-population") == 0) {
+            benchmarkPopulation = true;
+        } else if (strcmp(argv[i], "--bench-genomes") == 0) {
+            benchmarkGenomes = true;
+        } else if (strcmp(argv[i], "--bench-collisions") == 0) {
+            benchmarkCollisions = true;
+        } else if (strcmp(argv[i], "--bench-islands") == 0) {
+            benchmarkIslands = true;
+        } else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc) {
+            sim.obstacleMapFile = argv[++i];
+        } else if (strcmp(argv[i], "--selection") == 0 && i + 1 < argc) {
+            selectionMaskFile = argv[++i];
+        } else if (strcmp(argv[i], "--net-eval") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "scalar") == 0) {
+                sim.netEvaluator = NET_EVAL_SCALAR;
+            } else if (strcmp(argv[i], "batched") == 0) {
+                sim.netEvaluator = NET_EVAL_BATCHED;
+            } else {
+                fprintf(stderr, "Unknown net evaluator %s.\n", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--activation") == 0 && i + 1 < argc) {
+            if (!parseActivation(argv[++i], &sim.activation)) {
+                fprintf(stderr, "Unknown activation %s.\n", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--compare-activation") == 0) {
+            sim.compareActivation = true;
+            sim.headless = true;
+            if (i + 1 < argc && parseActivation(argv[i + 1], &sim.comparedActivation)) {
+                i++;
+                comparedActivationGiven = true;
+            }
+        } else if (strcmp(argv[i], "--mutation-rates") == 0 && i + 1 < argc) {
+            MutationRates rates;
+            if (sscanf(argv[++i], "%f,%f,%f", &rates.bitFlip, &rates.weightPerturbation, &rates.duplication) != 3 ||
+                    rates.bitFlip < 0.0f || rates.weightPerturbation < 0.0f || rates.duplication < 0.0f ||
+                    rates.bitFlip + rates.weightPerturbation + rates.duplication > 1.0f) {
+                fprintf(stderr, "Could not parse mutation rates from argument.\n");
+            } else {
+                sim.mutationRates = rates;
+            }
+        } else if (strcmp(argv[i], "--islands") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d", &sim.islands) != 1 || sim.islands < 1) {
+                fprintf(stderr, "Could not parse island count from argument.\n");
+                sim.islands = 1;
+            }
+            // islands are only ever run headless
+            sim.headless = sim.headless || sim.islands > 1;
+        } else if (strcmp(argv[i], "--migration") == 0 && i + 1 < argc) {
+            if (!parseMigrationTopology(argv[++i], &sim.migration)) {
+                fprintf(stderr, "Unknown migration topology %s.\n", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--migration-interval") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d", &sim.migrationInterval) != 1 || sim.migrationInterval < 1) {
+                fprintf(stderr, "Could not parse migration interval from argument.\n");
+                sim.migrationInterval = 10;
+            }
+        } else if (strcmp(argv[i], "--migrants") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d", &sim.migrants) != 1 || sim.migrants < 0) {
+                fprintf(stderr, "Could not parse migrant count from argument.\n");
+                sim.migrants = 5;
+            }
+        } else if (strcmp(argv[i], "--island-processes") == 0) {
+            sim.islandProcesses = true;
+        } else if (strcmp(argv[i], "--island-cpus") == 0 && i + 1 < argc) {
+            sim.islandCpus = argv[++i];
+        } else if (strcmp(argv[i], "--world") == 0 && i + 1 < argc) {
+            Size size;
+            if (sscanf(argv[++i], "%dx%d", &size.w, &size.h) != 2 || size.w < 1 || size.h < 1 ||
+                    size.w > MAX_WORLD_SIDE || size.h > MAX_WORLD_SIDE) {
+                fprintf(stderr, "Could not parse world size from argument.\n");
+            } else {
+                worldSize = size;
+            }
+        } else if (strcmp(argv[i], "--population") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d", &population) != 1 || population < 1) {
+                fprintf(stderr, "Could not parse population from argument.\n");
+                population = 1000;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d", &sim.threads) != 1 || sim.threads < 1) {
+                fprintf(stderr, "Could not parse thread count from argument.\n");
+                sim.threads = 1;
+            }
+        } else if (sscanf(argv[i], "%d", &sim.seed) != 1) {
             fprintf(stderr, "Could not parse seed from argument.\n");
             sim.seed = time(NULL);
         }
-    } else {
-        sim.seed = time(NULL);
     }
 
+    // by default the fast and the exact activation are compared with each other
+    if (!comparedActivationGiven) {
+        sim.comparedActivation = sim.activation == ACTIVATION_EXACT ? ACTIVATION_FAST : ACTIVATION_EXACT;
+    }
+
+    initCollisionSearch();
+
     Rect obstacles[2] = {
         (Rect){.x = 32, .y = 48, .w = 2, .h = 32},
         (Rect){.x = 94, .y = 48, .w = 2, .h = 32},
     };
 
     sim.selector = leftHalfSelector;
-    sim.mutationRate = 0.05;
+    sim.matingMode = MATING_UNIFORM;
     sim.obstacles = obstacles;
     sim.obstaclesCount = 0;
-    sim.size = (Size) {
-        .w = 128, .h = 128
-    };
+    sim.size = worldSize;
     sim.energyToMove = 0.01;
     sim.energyToRest = 0.01;
     sim.maxInternalNeurons = 1;
     sim.numberOfGenes = 2;
-    sim.population = 1000;
+    sim.population = population;
     sim.stepsPerGeneration = 200;
     sim.maxGenerations = 100;
 
+    // nets are built in room for MAX_CONNECTIONS connections, one per gene
+    if (sim.numberOfGenes < 1 || sim.numberOfGenes > MAX_CONNECTIONS) {
+        fprintf(stderr, "Genomes must have between 1 and %d genes, not %d\n", MAX_CONNECTIONS, sim.numberOfGenes);
+        return EXIT_FAILURE;
+    }
+
+    if (benchmarkNets) {
+        return runNetBenchmark(&sim);
+    }
+    if (benchmarkPopulation) {
+        return runPopulationBenchmark(&sim);
+    }
+    if (benchmarkGenomes) {
+        return runGenomeBenchmark(&sim);
+    }
+    if (benchmarkCollisions) {
+        return runCollisionBenchmark(&sim);
+    }
+    if (benchmarkIslands) {
+        return runIslandBenchmark(&sim);
+    }
+
+    // obstacles are rasterised once up front so that every test is a lookup
+    sim.obstacleMap = createObstacleMap(sim.size);
+    for (size_t i = 0; i < sim.obstaclesCount; i++) {
+        addRectToObstacleMap(&sim.obstacleMap, sim.obstacles[i]);
+    }
+    if (sim.obstacleMapFile != NULL && !loadObstacleMap(&sim.obstacleMap, sim.obstacleMapFile)) {
+        return EXIT_FAILURE;
+    }
+
+    // and so are the inputs that only depend on position
+    sim.sensorField = createSensorField(sim.size);
+
+    // and the survival zone, unless it comes from an image
+    if (selectionMaskFile != NULL) {
+        sim.selector = (SelectionCriteria) {
+            .fn = NULL, .name = selectionMaskFile
+        };
+    }
+    sim.selectionMask = createSelectionMask(&sim);
+    if (selectionMaskFile != NULL && !loadSelectionMask(&sim.selectionMask, selectionMaskFile)) {
+        return EXIT_FAILURE;
+    }
+
+    // checked before any simulation or the visualiser starts, since neither
+    // can place the organisms otherwise
+    if ((size_t)sim.population > countFreeCells(&sim)) {
+        fprintf(stderr, "A population of %d does not fit in the %zu cells without obstacles\n",
+                sim.population, countFreeCells(&sim));
+        return EXIT_FAILURE;
+    }
+
 #if FEATURE_VISUALISER
+    if (sim.headless) {
+        int status = sim.islands > 1 ? runIslands(&sim) : runSimulation(&sim);
+        destroyObstacleMap(&sim.obstacleMap);
+        destroySensorField(&sim.sensorField);
+        destroySelectionMask(&sim.selectionMask);
+        return status;
+    }
+
     sem_init(&simulatorReadyLock, 0, 0);
     sem_init(&visualiserReadyLock, 0, 0);
 
@@ -72,10 +273,17 @@ int main(int argc, const char* argv[])
 
     sem_destroy(&visualiserReadyLock);
     sem_destroy(&simulatorReadyLock);
+    destroyObstacleMap(&sim.obstacleMap);
+    destroySensorField(&sim.sensorField);
+    destroySelectionMask(&sim.selectionMask);
+    return EXIT_SUCCESS;
 #else
-    runSimulation(&sim);
+    int status = sim.islands > 1 ? runIslands(&sim) : runSimulation(&sim);
+    destroyObstacleMap(&sim.obstacleMap);
+    destroySensorField(&sim.sensorField);
+    destroySelectionMask(&sim.selectionMask);
+    return status;
 #endif
-    return EXIT_SUCCESS;
 }
 
 #if FEATURE_VISUALISER
@@ -0,0 +1,103 @@
+#include "Random.h"
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// The counter holds (block, organism id, step, generation) and the key holds
+// (seed, purpose), so every stream is an independent sequence of blocks.
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+static void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+{
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)p1;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)p0;
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+RandomStream makeRandomStream(int seed, int generation, int step, OrganismId id, RandomPurpose purpose)
+{
+    return (RandomStream) {
+        .key = { (uint32_t)seed, (uint32_t)purpose },
+        .counter = { 0, (uint32_t)id, (uint32_t)step, (uint32_t)generation },
+        .buffered = 0,
+    };
+}
+
+static void nextBlock(RandomStream* rng, uint32_t out[4])
+{
+    philox4x32(rng->counter, rng->key, out);
+    rng->counter[0]++;
+}
+
+uint32_t randomUint32(RandomStream* rng)
+{
+    if (rng->buffered == 0) {
+        nextBlock(rng, rng->buffer);
+        rng->buffered = 4;
+    }
+
+    return rng->buffer[4 - rng->buffered--];
+}
+
+// Returns a uniformly distributed integer in [0, n) using Lemire's
+// multiply-and-reject method.
+uint32_t randomBelow(RandomStream* rng, uint32_t n)
+{
+    uint64_t m = (uint64_t)randomUint32(rng) * n;
+    uint32_t low = (uint32_t)m;
+
+    if (low < n) {
+        uint32_t threshold = -n % n;
+        while (low < threshold) {
+            m = (uint64_t)randomUint32(rng) * n;
+            low = (uint32_t)m;
+        }
+    }
+
+    return (uint32_t)(m >> 32);
+}
+
+// Returns a uniformly distributed float in [0, 1).
+float randomFloat(RandomStream* rng)
+{
+    return (float)(randomUint32(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Fills out with count random words. Whole blocks are written straight to the
+// output, so this is the cheapest way to draw many words at once.
+void randomFill(RandomStream* rng, uint32_t* out, size_t count)
+{
+    size_t i = 0;
+
+    while (i < count && rng->buffered > 0) {
+        out[i++] = randomUint32(rng);
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        nextBlock(rng, &out[i]);
+    }
+
+    while (i < count) {
+        out[i++] = randomUint32(rng);
+    }
+}
@@ -0,0 +1,118 @@
+#include "SelectionMask.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Image.h"
+
+static size_t getSelectionMaskWords(Size size)
+{
+    return ((size_t)size.w * size.h + 31) / 32;
+}
+
+// Rasterises sim->selector over every cell of the world, so that selecting is
+// a lookup however much work the selector does.
+SelectionMask createSelectionMask(Simulation* sim)
+{
+    SelectionMask mask = {
+        .size = sim->size,
+        .bits = NULL,
+    };
+
+    if ((size_t)sim->size.w * sim->size.h > SELECTION_MASK_MAX_CELLS || sim->selector.fn == NULL) {
+        return mask;
+    }
+
+    mask.bits = calloc(getSelectionMaskWords(mask.size), sizeof(uint32_t));
+
+    for (int y = 0; y < mask.size.h; y++) {
+        for (int x = 0; x < mask.size.w; x++) {
+            uint32_t cell = (uint32_t)y * mask.size.w + x;
+            if (sim->selector.fn((Pos) { .x = x, .y = y }, sim)) {
+                mask.bits[cell >> 5] |= 1u << (cell & 31);
+            }
+        }
+    }
+
+    return mask;
+}
+
+// Replaces the mask with the survival zone in a PBM (P1/P4) or PGM (P2/P5)
+// image, where set pixels survive. The image is stretched to fit the world
+// with nearest-neighbour sampling.
+bool loadSelectionMask(SelectionMask* mask, const char* filename)
+{
+    if ((size_t)mask->size.w * mask->size.h > SELECTION_MASK_MAX_CELLS) {
+        fprintf(stderr, "The world is too large for a selection image\n");
+        return false;
+    }
+
+    int w, h;
+    bool* pixels = readBitmapImage(filename, &w, &h);
+    if (pixels == NULL) {
+        return false;
+    }
+
+    free(mask->bits);
+    mask->bits = calloc(getSelectionMaskWords(mask->size), sizeof(uint32_t));
+
+    for (int y = 0; y < mask->size.h; y++) {
+        int srcY = (int)((int64_t)y * h / mask->size.h);
+        for (int x = 0; x < mask->size.w; x++) {
+            int srcX = (int)((int64_t)x * w / mask->size.w);
+            uint32_t cell = (uint32_t)y * mask->size.w + x;
+            if (pixels[(size_t)srcY * w + srcX]) {
+                mask->bits[cell >> 5] |= 1u << (cell & 31);
+            }
+        }
+    }
+
+    free(pixels);
+    return true;
+}
+
+void destroySelectionMask(SelectionMask* mask)
+{
+    free(mask->bits);
+    mask->bits = NULL;
+}
+
+size_t getSelectionMaskBytes(SelectionMask* mask)
+{
+    if (mask->bits == NULL) return 0;
+
+    return getSelectionMaskWords(mask->size) * sizeof(uint32_t);
+}
+
+// Reads every organism's bit out of the mask, which vectorises to a gather.
+// The bools are read and written as bytes, and cells as signed ints, which is
+// what the vectoriser needs, and masks never have more cells than an int holds.
+__attribute__((target_clones("avx512f", "avx2", "default")))
+static void gatherSelection(SelectionMask* mask, Pos* restrict pos, bool* restrict alive, int count,
+                            bool* restrict selected)
+{
+    uint32_t* bits = mask->bits;
+    int32_t w = mask->size.w;
+    uint8_t* aliveBytes = (uint8_t*)alive;
+    uint8_t* selectedBytes = (uint8_t*)selected;
+
+    for (int i = 0; i < count; i++) {
+        int32_t cell = pos[i].y * w + pos[i].x;
+        int32_t word = bits[cell >> 5];
+        selectedBytes[i] = aliveBytes[i] & ((word >> (cell & 31)) & 1);
+    }
+}
+
+// Works out which of the count organisms at pos are alive and survive
+// selection.
+void selectOrganisms(Simulation* sim, Pos* pos, bool* alive, int count, bool* selected)
+{
+    if (sim->selectionMask.bits != NULL) {
+        gatherSelection(&sim->selectionMask, pos, alive, count, selected);
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        selected[i] = alive[i] && sim->selector.fn(pos[i], sim);
+    }
+}
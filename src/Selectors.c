@@ -1,8 +1,8 @@
 #include "Selectors.h"
 
-bool centerXSelectorFn(Organism *org, Simulation *sim)
+bool centerXSelectorFn(Pos pos, Simulation *sim)
 {
-    return ((org->pos.x > (sim->size.w / 3)) && (org->pos.x < (2 * sim->size.w / 3)));
+    return ((pos.x > (sim->size.w / 3)) && (pos.x < (2 * sim->size.w / 3)));
 }
 
 const char centerXSelectorName[] = "Center (x)";
@@ -12,10 +12,10 @@ SelectionCriteria centerXSelector = {
     .name = centerXSelectorName,
 };
 
-bool centerYSelectorFn(Organism *org, Simulation *sim)
+bool centerYSelectorFn(Pos pos, Simulation *sim)
 {
-    return ((org->pos.y > (sim->size.h / 3)) &&
-            (org->pos.y < (2 * sim->size.h / 3)));
+    return ((pos.y > (sim->size.h / 3)) &&
+            (pos.y < (2 * sim->size.h / 3)));
 }
 
 const char centerYSelectorName[] = "Center (y)";
@@ -25,9 +25,9 @@ SelectionCriteria centerYSelector = {
     .name = centerYSelectorName,
 };
 
-bool centerSelectorFn(Organism *org, Simulation *sim)
+bool centerSelectorFn(Pos pos, Simulation *sim)
 {
-    return centerXSelectorFn(org, sim) && centerYSelectorFn(org, sim);
+    return centerXSelectorFn(pos, sim) && centerYSelectorFn(pos, sim);
 }
 
 const char centerSelectorName[] = "Center (Square)";
@@ -37,11 +37,19 @@ SelectionCriteria centerSelector = {
     .name = centerSelectorName,
 };
 
-bool circleCenterSelectorFn(Organism* org, Simulation *sim)
+// In 64 bits, since the square of a distance across a large world overflows
+// an int.
+static int64_t getDistanceFromCenterSquared(Pos pos, Simulation *sim)
+{
+    int64_t dx = sim->size.w / 2 - pos.x;
+    int64_t dy = sim->size.h / 2 - pos.y;
+    return dx * dx + dy * dy;
+}
+
+bool circleCenterSelectorFn(Pos pos, Simulation *sim)
 {
     return
-        ((sim->size.w / 2 - org->pos.x) * (sim->size.w / 2 - org->pos.x) +
-         (sim->size.h / 2 - org->pos.y) * (sim->size.h / 2 - org->pos.y)) < (20 * 20);
+        getDistanceFromCenterSquared(pos, sim) < (20 * 20);
 }
 
 const char circleCenterSelectorName[] = "Center (Circle)";
@@ -51,11 +59,10 @@ SelectionCriteria circleCenterSelector = {
     .name = circleCenterSelectorName,
 };
 
-bool hollowCircleSelectorFn(Organism* org, Simulation *sim)
+bool hollowCircleSelectorFn(Pos pos, Simulation *sim)
 {
     return
-        ((sim->size.w / 2 - org->pos.x) * (sim->size.w / 2 - org->pos.x) +
-         (sim->size.h / 2 - org->pos.y) * (sim->size.h / 2 - org->pos.y)) > (60 * 60);
+        getDistanceFromCenterSquared(pos, sim) > (60 * 60);
 }
 
 const char hollowCircleSelectorName[] = "Hollow Circle";
@@ -66,13 +73,11 @@ SelectionCriteria hollowCircleSelector = {
 };
 
 
-bool donutSelectorFn(Organism* org, Simulation *sim)
+bool donutSelectorFn(Pos pos, Simulation *sim)
 {
     return
-        (((sim->size.w / 2 - org->pos.x) * (sim->size.w / 2 - org->pos.x) +
-         (sim->size.h / 2 - org->pos.y) * (sim->size.h / 2 - org->pos.y)) < (32 * 32)) &&
-        ((sim->size.w / 2 - org->pos.x) * (sim->size.w / 2 - org->pos.x) +
-         (sim->size.h / 2 - org->pos.y) * (sim->size.h / 2 - org->pos.y)) > (24 * 24);
+        getDistanceFromCenterSquared(pos, sim) < (32 * 32) &&
+        getDistanceFromCenterSquared(pos, sim) > (24 * 24);
 }
 
 const char donutSelectorName[] = "Donut";
@@ -83,9 +88,9 @@ SelectionCriteria donutSelector = {
 };
 
 
-bool bottomHalfSelectorFn(Organism *org, Simulation *sim)
+bool bottomHalfSelectorFn(Pos pos, Simulation *sim)
 {
-    return (org->pos.y >= (sim->size.h / 2));
+    return (pos.y >= (sim->size.h / 2));
 }
 
 const char bottomHalfSelectorName[] = "Bottom Half";
@@ -95,9 +100,9 @@ SelectionCriteria bottomHalfSelector = {
     .name = bottomHalfSelectorName,
 };
 
-bool topHalfSelectorFn(Organism *org, Simulation *sim)
+bool topHalfSelectorFn(Pos pos, Simulation *sim)
 {
-    return (org->pos.y < (sim->size.h / 2));
+    return (pos.y < (sim->size.h / 2));
 }
 
 const char topHalfSelectorName[] = "Top Half";
@@ -107,9 +112,9 @@ SelectionCriteria topHalfSelector = {
     .name = topHalfSelectorName,
 };
 
-bool leftHalfSelectorFn(Organism* org, Simulation *sim)
+bool leftHalfSelectorFn(Pos pos, Simulation *sim)
 {
-    return (org->pos.x < (sim->size.h / 2));
+    return (pos.x < (sim->size.h / 2));
 }
 
 const char leftHalfSelectorName[] = "Left Half";
@@ -119,9 +124,9 @@ SelectionCriteria leftHalfSelector = {
     .name = leftHalfSelectorName,
 };
 
-bool rightHalfSelectorFn(Organism* org, Simulation *sim)
+bool rightHalfSelectorFn(Pos pos, Simulation *sim)
 {
-    return (org->pos.x > (sim->size.h / 2));
+    return (pos.x > (sim->size.h / 2));
 }
 
 const char rightHalfSelectorName[] = "Right Half";
@@ -131,9 +136,9 @@ SelectionCriteria rightHalfSelector = {
     .name = rightHalfSelectorName,
 };
 
-bool farLeftSelectorFn(Organism *org, Simulation *sim)
+bool farLeftSelectorFn(Pos pos, Simulation *sim)
 {
-    return org->pos.x < sim->size.w * 0.2;
+    return pos.x < sim->size.w * 0.2;
 }
 
 const char farLeftSelectorName[] = "Left 20%";
@@ -143,9 +148,9 @@ SelectionCriteria farLeftSelector = {
     .name = farLeftSelectorName,
 };
 
-bool farRightSelectorFn(Organism *org, Simulation *sim)
+bool farRightSelectorFn(Pos pos, Simulation *sim)
 {
-    return org->pos.x > sim->size.w * 0.8;
+    return pos.x > sim->size.w * 0.8;
 }
 
 const char farRightSelectorName[] = "Right 20%";
@@ -155,9 +160,9 @@ SelectionCriteria farRightSelector = {
     .name = farRightSelectorName,
 };
 
-bool farLeftOrRightSelectorFn(Organism *org, Simulation *sim)
+bool farLeftOrRightSelectorFn(Pos pos, Simulation *sim)
 {
-    return farLeftSelectorFn(org, sim) || farRightSelectorFn(org, sim);
+    return farLeftSelectorFn(pos, sim) || farRightSelectorFn(pos, sim);
 }
 
 const char farLeftOrRightSelectorName[] = "L/R Edges";
@@ -0,0 +1,102 @@
+#include "SensorField.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+typedef float (*PositionSensor)(Size size, Pos pos);
+
+static float senseWorldX(Size size, Pos pos)
+{
+    return 2.0 * (float)pos.x / (float)size.w - 1.0;
+}
+
+static float senseWorldY(Size size, Pos pos)
+{
+    return 2.0 * (float)pos.y / (float)size.h - 1.0;
+}
+
+static float senseProximityToNearestEdge(Size size, Pos pos)
+{
+    int nearX = size.w / 2 - abs(size.w / 2 - pos.x);
+    int nearY = size.h / 2 - abs(size.h / 2 - pos.y);
+
+    return nearX < nearY ? 1.0f - 2.0f * (float)nearX / size.w
+           : 1.0f - 2.0f * (float)nearY / size.h;
+}
+
+static float senseProximityToOrigin(Size size, Pos pos)
+{
+    int diffX = abs(size.w / 2 - pos.x);
+    int diffY = abs(size.h / 2 - pos.y);
+    float length = sqrtf((float)diffX * diffX + (float)diffY * diffY);
+
+    return length / ((float)size.w * size.h);
+}
+
+// Every input that only depends on the organism's position. Adding one here
+// is all it takes for it to be tabulated.
+static const PositionSensor positionSensors[IN_MAX] = {
+    [IN_WORLD_X] = senseWorldX,
+    [IN_WORLD_Y] = senseWorldY,
+    [IN_PROXIMITY_TO_NEAREST_EDGE] = senseProximityToNearestEdge,
+    [IN_PROXIMITY_TO_ORIGIN] = senseProximityToOrigin,
+};
+
+SensorField createSensorField(Size size)
+{
+    SensorField field = {
+        .size = size,
+        .sensorCount = 0,
+        .values = NULL,
+    };
+
+    for (int input = 0; input < IN_MAX; input++) {
+        field.slots[input] = positionSensors[input] != NULL ? field.sensorCount++ : -1;
+    }
+
+    size_t cells = (size_t)size.w * size.h;
+    if (cells > SENSOR_FIELD_MAX_CELLS) {
+        return field;
+    }
+
+    field.values = malloc(cells * field.sensorCount * sizeof(float));
+
+    for (int y = 0; y < size.h; y++) {
+        for (int x = 0; x < size.w; x++) {
+            float* values = &field.values[((size_t)y * size.w + x) * field.sensorCount];
+
+            for (int input = 0; input < IN_MAX; input++) {
+                if (field.slots[input] == -1) continue;
+
+                values[field.slots[input]] = positionSensors[input](size, (Pos) {
+                    .x = x, .y = y
+                });
+            }
+        }
+    }
+
+    return field;
+}
+
+void destroySensorField(SensorField* field)
+{
+    free(field->values);
+    field->values = NULL;
+}
+
+size_t getSensorFieldBytes(SensorField* field)
+{
+    if (field->values == NULL) return 0;
+
+    return (size_t)field->size.w * field->size.h * field->sensorCount * sizeof(float);
+}
+
+// Inputs that do not only depend on the position read as 0.
+float computePositionSensor(Size size, InputType input, Pos pos)
+{
+    if (positionSensors[input] == NULL) {
+        return 0.0f;
+    }
+
+    return positionSensors[input](size, pos);
+}
@@ -14,8 +14,25 @@
 #include "Visualiser.h"
 #include "Geometry.h"
 #include "Organism.h"
+#include "Genome.h"
+#include "ThreadPool.h"
+#include "Random.h"
+#include "Survivors.h"
+#include "Occupancy.h"
+#include "ObstacleMap.h"
+#include "SensorField.h"
+#include "SelectionMask.h"
+#include "CellSampler.h"
+#include "Islands.h"
+#include "NetBatch.h"
+#include "NetCache.h"
+#include "Arena.h"
+#include "OrganismStore.h"
+#include "NeuralNet.h"
+#include "Activation.h"
 
 static volatile bool interrupted = false;
+static bool headless = false;
 #if FEATURE_VISUALISER
 static sem_t paused;
 static sem_t framePaused;
@@ -27,8 +44,10 @@ void signalHandler(int sig)
     if (sig == SIGINT) {
         interrupted = true;
 #if FEATURE_VISUALISER
-        sem_post(&paused);
-        sem_post(&framePaused);
+        if (!headless) {
+            sem_post(&paused);
+            sem_post(&framePaused);
+        }
 #endif
         // printf("Interrupt sent\n");
     }
@@ -83,37 +102,252 @@ void simSendFrameContinue(void)
 #endif
 }
 
-void runSimulation(Simulation *s)
+#if FEATURE_VISUALISER
+// Blocks while the visualiser has paused the simulation or is waiting to draw
+// the current frame. Returns false if the simulation was interrupted.
+static bool waitForVisualiser(void)
+{
+    sem_wait(&paused);
+    sem_post(&paused);
+    if (interrupted) return false;
+
+    sem_wait(&framePaused);
+    sem_post(&framePaused);
+    if (interrupted) return false;
+
+    return true;
+}
+#endif
+
+static uint64_t nowInNanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+typedef struct {
+    OrganismStore* orgs;
+    OccupancyView prevOrgsByPosition;
+    Simulation* sim;
+    int generation;
+    int step;
+    NetDivergence* divergence;
+} ThinkJob;
+
+static void thinkWorker(void* ctx, int start, int end)
+{
+    ThinkJob* job = (ThinkJob*)ctx;
+
+    for (int i = start; i < end; i++) {
+        organismThink(job->orgs, i, job->prevOrgsByPosition, job->sim, job->generation, job->step);
+    }
+}
+
+static void senseWorker(void* ctx, int start, int end)
+{
+    ThinkJob* job = (ThinkJob*)ctx;
+
+    for (int i = start; i < end; i++) {
+        organismSense(job->orgs, i, job->prevOrgsByPosition, job->sim, job->step);
+    }
+}
+
+static void decideWorker(void* ctx, int start, int end)
+{
+    ThinkJob* job = (ThinkJob*)ctx;
+
+    for (int i = start; i < end; i++) {
+        organismDecide(job->orgs, i, job->prevOrgsByPosition, job->sim, job->generation, job->step);
+    }
+}
+
+// How organisms settle into cells in a step. Those that can take the cell
+// they moved to unless another organism takes it too are grouped by its tile,
+// in id order, and each tile is claimed by one thread, with the lowest id
+// winning each cell. The rest then settle one by one in id order.
+typedef struct {
+    OrganismStore* orgs;
+    OccupancyView orgsByPosition;
+    OccupancyView prevOrgsByPosition;
+    Simulation* sim;
+
+    // the tile slot each organism claimed its cell in, or -1 if it settles
+    // in id order, which is also what is left for organisms that lost theirs
+    int* slots;
+
+    // the claimants of tiles[t] are claimants[tileStarts[t]] onwards, up to
+    // the start of the next tile, with the cells they claim copied alongside
+    // so that each tile reads them in order
+    OrganismId* claimants;
+    Pos* claimedCells;
+    int* tiles;
+    int* tileStarts;
+    int tileCount;
+
+    // a count per tile slot, for grouping the claimants
+    int* slotCounts;
+    int slotCapacity;
+} ActJob;
+
+static void prepareActWorker(void* ctx, int start, int end)
+{
+    ActJob* job = (ActJob*)ctx;
+
+    for (int i = start; i < end; i++) {
+        job->slots[i] = prepareOrganismAct(job->orgs, i, job->sim, job->orgsByPosition, job->prevOrgsByPosition);
+    }
+}
+
+static void claimWorker(void* ctx, int start, int end)
+{
+    ActJob* job = (ActJob*)ctx;
+
+    for (int t = start; t < end; t++) {
+        for (int c = job->tileStarts[t]; c < job->tileStarts[t + 1]; c++) {
+            OrganismId id = job->claimants[c];
+
+            if (!claimTileCell(job->orgsByPosition, job->tiles[t], job->claimedCells[c], id)) {
+                job->slots[id] = -1;
+            }
+        }
+    }
+}
+
+// Sorts the organisms that claim in parallel by tile, keeping them in id
+// order within each tile.
+static void groupClaimants(ActJob* job, int population)
+{
+    int capacity = job->orgsByPosition.tiles->capacity;
+    if (capacity > job->slotCapacity) {
+        job->slotCapacity = 2 * capacity;
+        job->slotCounts = realloc(job->slotCounts, job->slotCapacity * sizeof(int));
+        job->tiles = realloc(job->tiles, job->slotCapacity * sizeof(int));
+        job->tileStarts = realloc(job->tileStarts, (job->slotCapacity + 1) * sizeof(int));
+    }
+    memset(job->slotCounts, 0, capacity * sizeof(int));
+
+    for (int i = 0; i < population; i++) {
+        if (job->slots[i] >= 0) {
+            job->slotCounts[job->slots[i]]++;
+        }
+    }
+
+    // slotCounts becomes where each tile's claimants start
+    int claimants = 0;
+    job->tileCount = 0;
+    for (int slot = 0; slot < capacity; slot++) {
+        int count = job->slotCounts[slot];
+        if (count == 0) continue;
+
+        job->tiles[job->tileCount] = slot;
+        job->tileStarts[job->tileCount++] = claimants;
+        job->slotCounts[slot] = claimants;
+        claimants += count;
+    }
+    job->tileStarts[job->tileCount] = claimants;
+
+    for (int i = 0; i < population; i++) {
+        if (job->slots[i] >= 0) {
+            int c = job->slotCounts[job->slots[i]]++;
+            job->claimants[c] = i;
+            job->claimedCells[c] = getOrganismPos(job->orgs, i);
+        }
+    }
+}
+
+// Thinks like thinkWorker, but also evaluates each net with the compared
+// activation and records how far its outputs drift. The organisms still act
+// on the activation the simulation was asked for.
+static void compareWorker(void* ctx, int start, int end)
+{
+    ThinkJob* job = (ThinkJob*)ctx;
+    ActivationMode activation = job->sim->activation;
+    ActivationMode other = job->sim->comparedActivation;
+
+    for (int i = start; i < end; i++) {
+        job->divergence[i] = (NetDivergence) { 0 };
+        if (!isOrganismAlive(job->orgs, i)) continue;
+
+        organismSense(job->orgs, i, job->prevOrgsByPosition, job->sim, job->step);
+        job->divergence[i] = compareNeuralNet(&getOrganism(job->orgs, i)->net, activation, other);
+        organismDecide(job->orgs, i, job->prevOrgsByPosition, job->sim, job->generation, job->step);
+    }
+}
+
+int runSimulation(Simulation *s)
 {
     Simulation *sim = s;
 #if FEATURE_VISUALISER
-    sem_init(&paused, 0, 1);
-    sem_init(&framePaused, 0, 0);
+    headless = sim->headless;
+    if (!headless) {
+        sem_init(&paused, 0, 1);
+        sem_init(&framePaused, 0, 0);
+    }
+#else
+    headless = true;
 #endif
 
     signal(SIGINT, &signalHandler);
 
-    srand(sim->seed);
-    printf("Seed is %d\n", sim->seed);
+    bool quiet = sim->quiet;
+    if (!quiet) printf("Seed is %d\n", sim->seed);
+
+    ThreadPool* pool = createThreadPool(sim->threads);
+    if (!quiet) printf("Stepping with %d thread(s)\n", getThreadPoolSize(pool));
+
+    OrganismStore stores[2] = { createOrganismStore(sim->population), createOrganismStore(sim->population) };
+    OrganismStore *orgs = &stores[0];
+    OrganismStore *nextGenOrgs = &stores[1];
+    OccupancyGrid occupancy = createOccupancyGrid(sim->size, sim->population);
+    CellSampler freeCells = createCellSampler(sim);
+    if (!quiet) {
+        printf("Obstacle map blocks %'zu cells\n", countObstacleCells(&sim->obstacleMap));
+        printf("Sensor field uses %'zu bytes\n", getSensorFieldBytes(&sim->sensorField));
+        printf("Selection mask uses %'zu bytes\n", getSelectionMaskBytes(&sim->selectionMask));
+    }
+
+    // each generation's genes and neurons, packed organism by organism
+    size_t arenaBytes = getOrganismArenaBytes(sim) * sim->population;
+    Arena arena = createArena(arenaBytes);
+    Arena nextArena = createArena(arenaBytes);
 
-    Organism *orgs = calloc(sim->population, sizeof(Organism));
-    Organism *nextGenOrgs = calloc(sim->population, sizeof(Organism));
-    Organism **orgsByPosition = calloc(sim->size.w * sim->size.h, sizeof(Organism*));
-    Organism **prevOrgsByPosition = calloc(sim->size.w * sim->size.h, sizeof(Organism*));
+    SurvivorIndex survivorIndex = createSurvivorIndex(sim->population);
 
-    NeuralConnection *connectionBuffer = calloc(MAX_CONNECTIONS * sim->population, sizeof(NeuralConnection));
-    Neuron* neuronBuffer = calloc(MAX_NEURONS * sim->population, sizeof(Neuron));
-    Gene* geneBuffer = calloc(sim->numberOfGenes * sim->population, sizeof(Gene));
+    // a generation and the next one being bred are alive at the same time
+    NetCache netCache = createNetCache(2 * sim->population);
 
-    NeuralConnection *nextConnectionBuffer = calloc(MAX_CONNECTIONS * sim->population, sizeof(NeuralConnection));
-    Neuron* nextNeuronBuffer = calloc(MAX_NEURONS * sim->population, sizeof(Neuron));
-    Gene* nextGeneBuffer = calloc(sim->numberOfGenes * sim->population, sizeof(Gene));
+    bool batched = sim->netEvaluator == NET_EVAL_BATCHED && !sim->compareActivation;
+    NetBatch netBatch = createNetBatch(batched ? sim->population : 0);
 
     for (int i = 0; i < sim->population; i++) {
-        orgs[i] = makeRandomOrganism(sim, orgsByPosition, &neuronBuffer[i * MAX_NEURONS], &connectionBuffer[i * MAX_CONNECTIONS], &geneBuffer[i * sim->numberOfGenes]);
-        orgs[i].id = i;
+        makeRandomOrganism(orgs, i, sim, getCurrentOccupancy(&occupancy, orgs), &freeCells, &netCache, &arena);
+        setOrganismByPosition(sim, getCurrentOccupancy(&occupancy, orgs), orgs, i);
+    }
+
+    if (!quiet) {
+        printf("Occupancy grid uses %'zu bytes for %d tile(s)\n", getOccupancyGridBytes(&occupancy),
+               occupancy.tiles.tileCount);
+    }
+
+    if (batched) {
+        buildNetBatch(&netBatch, orgs, sim->activation);
+    }
+    if (batched && !quiet) {
+        printf("Evaluating nets in %d batch(es) of up to %d using %'zu bytes, %d net(s) on their own\n",
+               netBatch.blockCount, NET_BATCH_LANES, netBatch.storageSize, netBatch.scalarCount);
     }
 
+    NetDivergence* divergence = sim->compareActivation ? calloc(sim->population, sizeof(NetDivergence)) : NULL;
+    NetDivergence totalDivergence = { 0 };
+    bool* selected = malloc(sim->population * sizeof(bool));
+    ActJob act = {
+        .sim = sim,
+        .slots = malloc(sim->population * sizeof(int)),
+        .claimants = malloc(sim->population * sizeof(OrganismId)),
+        .claimedCells = malloc(sim->population * sizeof(Pos)),
+    };
+
     float Ao10Buffer[10] = {0.0f};
     int Ao10Idx = 0;
     uint64_t lastTimeInMicroseconds;
@@ -124,87 +358,130 @@ void runSimulation(Simulation *s)
     lastTimeInMicroseconds = ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
 
 #if FEATURE_VISUALISER
-    sem_wait(&simulatorReadyLock);
-    if (interrupted) goto quitOuterLoop;
+    if (!headless) {
+        sem_wait(&simulatorReadyLock);
+        if (interrupted) goto quitOuterLoop;
+        visSendReady();
+    }
 #endif
-    visSendReady();
 
     for (int g = 0; g < sim->maxGenerations; g++) {
-        visSendGeneration(orgs, g);
-
 #if FEATURE_VISUALISER
-        sem_wait(&paused);
-        sem_post(&paused);
-        if (interrupted) goto quitOuterLoop;
+        if (!headless) {
+            visSendGeneration(orgs, g);
+            if (!waitForVisualiser()) goto quitOuterLoop;
+        }
 #endif
 
-#if FEATURE_VISUALISER
-        sem_wait(&framePaused);
-        sem_post(&framePaused);
-        if (interrupted) goto quitOuterLoop;
-#endif
+        NetDivergence generationDivergence = { 0 };
+        uint64_t generationStart = nowInNanoseconds();
 
         for (int step = 0; step < sim->stepsPerGeneration; step++) {
-            memcpy(prevOrgsByPosition, orgsByPosition, sim->size.h * sim->size.w * sizeof(Organism*));
-            memset(orgsByPosition, 0, sim->size.h * sim->size.w * sizeof(Organism*));
-
-            visSendStep(orgs, step);
+            uint64_t stepStart = sim->timings != NULL ? nowInNanoseconds() : 0;
+            advanceOccupancyGrid(&occupancy);
+            OccupancyView orgsByPosition = getCurrentOccupancy(&occupancy, orgs);
+            OccupancyView prevOrgsByPosition = getPreviousOccupancy(&occupancy, orgs);
 
 #if FEATURE_VISUALISER
-            sem_wait(&paused);
-            sem_post(&paused);
-            if (interrupted) goto quitOuterLoop;
+            if (!headless) {
+                visSendStep(orgs, step);
+                if (!waitForVisualiser()) goto quitOuterLoop;
+            }
 #endif
 
-#if FEATURE_VISUALISER
-            sem_wait(&framePaused);
-            sem_post(&framePaused);
-            if (interrupted) goto quitOuterLoop;
-#endif
+            // sensing, thinking and deciding where to move are independent per
+            // organism, and settling into cells is split between the threads
+            // by tile, see ActJob
+            ThinkJob job = {
+                .orgs = orgs,
+                .prevOrgsByPosition = prevOrgsByPosition,
+                .sim = sim,
+                .generation = g,
+                .step = step,
+                .divergence = divergence,
+            };
+            if (sim->compareActivation) {
+                threadPoolParallelFor(pool, sim->population, compareWorker, &job);
+                for (int i = 0; i < sim->population; i++) {
+                    addNetDivergence(&generationDivergence, divergence[i]);
+                }
+            } else if (batched) {
+                threadPoolParallelFor(pool, sim->population, senseWorker, &job);
+                runNetBatch(&netBatch, orgs, pool);
+                threadPoolParallelFor(pool, sim->population, decideWorker, &job);
+            } else {
+                threadPoolParallelFor(pool, sim->population, thinkWorker, &job);
+            }
+
+            uint64_t actStart = sim->timings != NULL ? nowInNanoseconds() : 0;
+            act.orgs = orgs;
+            act.orgsByPosition = orgsByPosition;
+            act.prevOrgsByPosition = prevOrgsByPosition;
+
+            threadPoolParallelFor(pool, sim->population, prepareActWorker, &act);
+            groupClaimants(&act, sim->population);
+            threadPoolParallelFor(pool, act.tileCount, claimWorker, &act);
 
+            // organisms that lost their cell, or couldn't claim it in
+            // parallel, look for a free one with the cells claimed so far
             for (int i = 0; i < sim->population; i++) {
-                organismRunStep(&orgs[i], orgsByPosition, prevOrgsByPosition, sim, step);
+                if (act.slots[i] == -1) {
+                    organismAct(orgs, i, orgsByPosition, prevOrgsByPosition, sim);
+                }
+            }
+
+            if (sim->timings != NULL) {
+                sim->timings->actNanoseconds += nowInNanoseconds() - actStart;
+            }
+
+            if (sim->timings != NULL && sim->timings->stepSamples != NULL) {
+                int sample = sim->timings->steps + step;
+                if (sample < sim->timings->stepSampleCapacity) {
+                    sim->timings->stepSamples[sample] = nowInNanoseconds() - stepStart;
+                }
             }
 
             if (interrupted) goto quitOuterLoop;
         }
 
+        if (sim->timings != NULL) {
+            sim->timings->steps += sim->stepsPerGeneration;
+            sim->timings->stepNanoseconds += nowInNanoseconds() - generationStart;
+        }
+
         if (interrupted) goto quitOuterLoop;
 
         int survivors = 0;
         int deadBeforeSelection = 0;
         int deadAfterSelection = 0;
+        clearSurvivorIndex(&survivorIndex);
+        selectOrganisms(sim, orgs->pos, orgs->alive, sim->population, selected);
         for (int i = 0; i < sim->population; i++) {
-            Organism *org = &orgs[i];
-
-            if (!org->alive) {
+            if (!isOrganismAlive(orgs, i)) {
                 deadBeforeSelection++;
                 continue;
             }
 
-            if (sim->selector.fn(org, sim)) {
+            if (selected[i]) {
                 survivors++;
+                addSurvivor(&survivorIndex, i, getOrganismEnergy(orgs, i));
             } else {
                 deadAfterSelection++;
-                org->alive = false;
+                setOrganismAlive(orgs, i, false);
             }
         }
 
-        visSendStep(orgs, sim->stepsPerGeneration - 1);
-
 #if FEATURE_VISUALISER
-        sem_wait(&paused);
-        sem_post(&paused);
-        if (interrupted) goto quitOuterLoop;
-#endif
-
-#if FEATURE_VISUALISER
-        sem_wait(&framePaused);
-        sem_post(&framePaused);
-        if (interrupted) goto quitOuterLoop;
+        if (!headless) {
+            visSendStep(orgs, sim->stepsPerGeneration - 1);
+            if (!waitForVisualiser()) goto quitOuterLoop;
+        }
 #endif
 
         float survivalRate = (float)survivors * 100.0f / sim->population;
+        if (sim->island != NULL) {
+            recordIslandGeneration(sim->island, g, survivors);
+        }
 
         Ao10Buffer[Ao10Idx] = survivalRate;
         Ao10Idx = (Ao10Idx + 1) % 10;
@@ -223,42 +500,69 @@ void runSimulation(Simulation *s)
         double generationsPerMinute = 60000000.0 / diff;
         double kiloStepsPerMinute = sim->stepsPerGeneration * 60000.0 / diff;
 
-        printf("Gen %d survival rate is %d/%d (%03.2f%%, %03.2f%% Ao10) with %d "
-               "dead before and "
-               "%d dead after selection. %.2f kSteps/min. %.2f Gen/min.\n",
-               g, survivors, sim->population, survivalRate, Ao10,
-               deadBeforeSelection, deadAfterSelection, kiloStepsPerMinute, generationsPerMinute);
+        if (!quiet) {
+            printf("Gen %d survival rate is %d/%d (%03.2f%%, %03.2f%% Ao10) with %d "
+                   "dead before and "
+                   "%d dead after selection. %.2f kSteps/min. %.2f Gen/min.\n",
+                   g, survivors, sim->population, survivalRate, Ao10,
+                   deadBeforeSelection, deadAfterSelection, kiloStepsPerMinute, generationsPerMinute);
+        }
+
+        if (sim->compareActivation) {
+            printf("Gen %d outputs differ by at most %.3g, %d/%d decision(s) changed\n",
+                   g, generationDivergence.maxOutputDifference,
+                   generationDivergence.decisionsChanged, generationDivergence.outputsCompared);
+            addNetDivergence(&totalDivergence, generationDivergence);
+        }
 
         if (survivors <= 1) {
             break;
         }
 
+        buildSurvivorIndex(&survivorIndex, sim->matingMode);
+        if (sim->island != NULL) {
+            exchangeMigrants(sim->island, orgs, &survivorIndex, g);
+        }
+
+        // the next generation is placed into an empty world
+        advanceOccupancyGrid(&occupancy);
+        OccupancyView orgsByPosition = getCurrentOccupancy(&occupancy, nextGenOrgs);
+        resetArena(&nextArena);
+        resetCellSampler(&freeCells);
+
+        // offspring are bred in id order, which is the order the schedule walks their genes in
+        MutationSchedule mutations = createMutationSchedule(sim->mutationRates,
+                                     makeRandomStream(sim->seed, g + 1, 0, 0, RNG_MUTATION));
+
         for (int i = 0; i < sim->population; i++) {
             Organism *a, *b;
-            findMates(orgs, sim->population, &a, &b);
-            nextGenOrgs[i] = makeOffspring(a, b, sim, orgsByPosition, &nextNeuronBuffer[i * MAX_NEURONS], &nextConnectionBuffer[i * MAX_CONNECTIONS], &nextGeneBuffer[i * sim->numberOfGenes]);
-            nextGenOrgs[i].id = i;
+            RandomStream matingRng = makeRandomStream(sim->seed, g + 1, 0, i, RNG_MATING);
+            findMates(orgs->orgs, &survivorIndex, &matingRng, &a, &b);
+            makeOffspring(nextGenOrgs, i, a, b, sim, orgsByPosition, &freeCells, g + 1, &mutations, &netCache, &nextArena);
+            setOrganismByPosition(sim, orgsByPosition, nextGenOrgs, i);
         }
 
         for (int i = 0; i < sim->population; i++) {
-            destroyOrganism(&orgs[i]);
+            releaseNeuralNet(&netCache, &getOrganism(orgs, i)->net);
+            destroyOrganism(getOrganism(orgs, i));
         }
 
-        void* tmp = orgs;
+        OrganismStore* tmp = orgs;
         orgs = nextGenOrgs;
         nextGenOrgs = tmp;
 
-        tmp = neuronBuffer;
-        neuronBuffer = nextNeuronBuffer;
-        nextNeuronBuffer = tmp;
+        Arena nextGenArena = nextArena;
+        nextArena = arena;
+        arena = nextGenArena;
 
-        tmp = connectionBuffer;
-        connectionBuffer = nextConnectionBuffer;
-        nextConnectionBuffer = tmp;
+        if (batched) {
+            buildNetBatch(&netBatch, orgs, sim->activation);
+        }
 
-        tmp = geneBuffer;
-        geneBuffer = nextGeneBuffer;
-        nextGeneBuffer = tmp;
+        if (sim->timings != NULL) {
+            sim->timings->generations++;
+            sim->timings->generationNanoseconds += nowInNanoseconds() - generationStart;
+        }
 
         if (interrupted || survivors <= 1)
             goto quitOuterLoop;
@@ -266,30 +570,68 @@ void runSimulation(Simulation *s)
     }
 
 quitOuterLoop:
-    if (interrupted) {
-        visSendQuit();
-    } else {
-        visSendDisconnected();
+    if (!headless) {
+        if (interrupted) {
+            visSendQuit();
+        } else {
+            visSendDisconnected();
+        }
+    }
+
+    if (!quiet) {
+        printf("Occupancy grid held at most %d tile(s) of %dx%d cells\n", occupancy.tiles.peakTileCount,
+               OCCUPANCY_TILE_SIDE, OCCUPANCY_TILE_SIDE);
+        printf("Genes and neurons took at most %'zu of the %'zu bytes set aside per generation\n",
+               arena.peak > nextArena.peak ? arena.peak : nextArena.peak, arena.capacity);
+        printf("Net cache hit %.2f%% of %'llu lookups, %d net(s) alive using %'zu bytes (%'zu at most)\n",
+               netCache.hits * 100.0 / (netCache.lookups ? netCache.lookups : 1), (unsigned long long)netCache.lookups,
+               netCache.liveEntries, netCache.liveBytes, netCache.peakBytes);
     }
 
     for (int i = 0; i < sim->population; i++) {
-        destroyOrganism(&orgs[i]);
+        releaseNeuralNet(&netCache, &getOrganism(orgs, i)->net);
+        destroyOrganism(getOrganism(orgs, i));
     }
 
 #if FEATURE_VISUALISER
-    sem_destroy(&paused);
-    sem_destroy(&framePaused);
+    if (!headless) {
+        sem_destroy(&paused);
+        sem_destroy(&framePaused);
+    }
 #endif
 
-    free(orgs);
-    free(nextGenOrgs);
-    free(orgsByPosition);
-    free(prevOrgsByPosition);
-
-    free(neuronBuffer);
-    free(nextNeuronBuffer);
-    free(connectionBuffer);
-    free(nextConnectionBuffer);
-    free(geneBuffer);
-    free(nextGeneBuffer);
+    destroyThreadPool(pool);
+    destroySurvivorIndex(&survivorIndex);
+    destroyNetBatch(&netBatch);
+    destroyNetCache(&netCache);
+    free(divergence);
+    free(selected);
+    free(act.slots);
+    free(act.claimants);
+    free(act.claimedCells);
+    free(act.tiles);
+    free(act.tileStarts);
+    free(act.slotCounts);
+
+    destroyOrganismStore(&stores[0]);
+    destroyOrganismStore(&stores[1]);
+    destroyOccupancyGrid(&occupancy);
+    destroyCellSampler(&freeCells);
+
+    destroyArena(&arena);
+    destroyArena(&nextArena);
+
+    if (!sim->compareActivation) {
+        return EXIT_SUCCESS;
+    }
+
+    float bound = FAST_TANH_MAX_OUTPUT_DIVERGENCE;
+    bool withinBound = totalDivergence.maxOutputDifference <= bound;
+    printf("%s and %s activation outputs differ by at most %.3g (bound %.3g), %d/%d decision(s) changed (%.4f%%)\n",
+           getActivationName(sim->activation), getActivationName(sim->comparedActivation),
+           totalDivergence.maxOutputDifference, bound, totalDivergence.decisionsChanged,
+           totalDivergence.outputsCompared,
+           totalDivergence.decisionsChanged * 100.0 / (totalDivergence.outputsCompared ? totalDivergence.outputsCompared : 1));
+
+    return withinBound ? EXIT_SUCCESS : EXIT_FAILURE;
 }
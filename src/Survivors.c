@@ -0,0 +1,127 @@
+#include "Survivors.h"
+
+#include <stdlib.h>
+
+SurvivorIndex createSurvivorIndex(int capacity)
+{
+    return (SurvivorIndex) {
+        .count = 0,
+        .capacity = capacity,
+        .ids = calloc(capacity, sizeof(OrganismId)),
+        .fitness = calloc(capacity, sizeof(float)),
+        .weighted = false,
+        .probability = calloc(capacity, sizeof(float)),
+        .alias = calloc(capacity, sizeof(int)),
+        .worklist = calloc(capacity, sizeof(int)),
+    };
+}
+
+void destroySurvivorIndex(SurvivorIndex* index)
+{
+    free(index->ids);
+    index->ids = NULL;
+
+    free(index->fitness);
+    index->fitness = NULL;
+
+    free(index->probability);
+    index->probability = NULL;
+
+    free(index->alias);
+    index->alias = NULL;
+
+    free(index->worklist);
+    index->worklist = NULL;
+
+    index->count = 0;
+    index->capacity = 0;
+}
+
+void clearSurvivorIndex(SurvivorIndex* index)
+{
+    index->count = 0;
+    index->weighted = false;
+}
+
+void addSurvivor(SurvivorIndex* index, OrganismId id, float fitness)
+{
+    index->ids[index->count] = id;
+    index->fitness[index->count] = fitness;
+    index->count++;
+}
+
+// Builds an alias table (Vose's method) so that survivors can be drawn with
+// probability proportional to their fitness in constant time.
+static void buildAliasTable(SurvivorIndex* index)
+{
+    int n = index->count;
+    float total = 0.0f;
+
+    for (int i = 0; i < n; i++) {
+        total += index->fitness[i];
+    }
+
+    if (total <= 0.0f) {
+        index->weighted = false;
+        return;
+    }
+
+    // small entries are pushed from the front of the worklist and large
+    // entries from the back
+    int* small = index->worklist;
+    int* large = index->worklist + n;
+    int smallCount = 0, largeCount = 0;
+
+    for (int i = 0; i < n; i++) {
+        index->probability[i] = index->fitness[i] * (float)n / total;
+        if (index->probability[i] < 1.0f) {
+            small[smallCount++] = i;
+        } else {
+            *(large - ++largeCount) = i;
+        }
+    }
+
+    while (smallCount > 0 && largeCount > 0) {
+        int s = small[--smallCount];
+        int l = *(large - largeCount);
+
+        index->alias[s] = l;
+        index->probability[l] = (index->probability[l] + index->probability[s]) - 1.0f;
+
+        if (index->probability[l] < 1.0f) {
+            largeCount--;
+            small[smallCount++] = l;
+        }
+    }
+
+    // anything left over is only off by rounding
+    while (largeCount > 0) {
+        index->probability[*(large - largeCount--)] = 1.0f;
+    }
+    while (smallCount > 0) {
+        index->probability[small[--smallCount]] = 1.0f;
+    }
+
+    index->weighted = true;
+}
+
+void buildSurvivorIndex(SurvivorIndex* index, MatingMode mode)
+{
+    index->weighted = false;
+
+    if (mode == MATING_FITNESS && index->count > 0) {
+        buildAliasTable(index);
+    }
+}
+
+// Returns the position in the index of a randomly drawn survivor.
+int sampleSurvivor(SurvivorIndex* index, RandomStream* rng)
+{
+    int i = randomBelow(rng, index->count);
+
+    if (index->weighted && randomFloat(rng) >= index->probability[i]) {
+        i = index->alias[i];
+    }
+
+    return i;
+}
@@ -0,0 +1,156 @@
+#include "ThreadPool.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    ThreadPool* pool;
+    int index;
+} Worker;
+
+struct ThreadPool_t {
+    int threadCount;
+    pthread_t* threads;
+    Worker* workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t workReady;
+    pthread_cond_t workDone;
+
+    // the job currently being run, valid while pending > 0
+    ThreadPoolFn fn;
+    void* ctx;
+    int count;
+
+    // incremented each time a new job is posted so that workers can tell
+    // a fresh job apart from a spurious wakeup
+    uint64_t jobNumber;
+    int pending;
+    bool quit;
+};
+
+// Every thread gets a fixed, contiguous slice of the range so the split only
+// depends on the thread count and never on scheduling.
+static void runSlice(ThreadPool* pool, int index)
+{
+    int start = (int)((int64_t)pool->count * index / pool->threadCount);
+    int end = (int)((int64_t)pool->count * (index + 1) / pool->threadCount);
+
+    if (start < end) {
+        pool->fn(pool->ctx, start, end);
+    }
+}
+
+static void* threadPoolWorker(void* args)
+{
+    Worker* worker = (Worker*)args;
+    ThreadPool* pool = worker->pool;
+    uint64_t lastJob = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->quit && pool->jobNumber == lastJob) {
+            pthread_cond_wait(&pool->workReady, &pool->lock);
+        }
+        if (pool->quit) break;
+
+        lastJob = pool->jobNumber;
+        pthread_mutex_unlock(&pool->lock);
+
+        runSlice(pool, worker->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->workDone);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+ThreadPool* createThreadPool(int threadCount)
+{
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    pool->threadCount = threadCount;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->workReady, NULL);
+    pthread_cond_init(&pool->workDone, NULL);
+
+    // the calling thread always runs slice 0 itself
+    pool->threads = calloc(threadCount, sizeof(pthread_t));
+    pool->workers = calloc(threadCount, sizeof(Worker));
+    for (int i = 1; i < threadCount; i++) {
+        pool->workers[i] = (Worker) {
+            .pool = pool, .index = i
+        };
+        if (pthread_create(&pool->threads[i], NULL, threadPoolWorker, &pool->workers[i]) != 0) {
+            fprintf(stderr, "Could not create worker thread\n");
+            exit(1);
+        }
+    }
+
+    return pool;
+}
+
+void destroyThreadPool(ThreadPool* pool)
+{
+    if (pool == NULL) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->threadCount; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->workDone);
+    pthread_cond_destroy(&pool->workReady);
+    pthread_mutex_destroy(&pool->lock);
+
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+}
+
+int getThreadPoolSize(ThreadPool* pool)
+{
+    return pool->threadCount;
+}
+
+// Runs fn over [0, count) split across all threads in the pool and returns
+// once every slice has completed.
+void threadPoolParallelFor(ThreadPool* pool, int count, ThreadPoolFn fn, void* ctx)
+{
+    if (count <= 0) return;
+
+    if (pool->threadCount == 1) {
+        fn(ctx, 0, count);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->count = count;
+    pool->pending = pool->threadCount - 1;
+    pool->jobNumber++;
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->lock);
+
+    runSlice(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->workDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
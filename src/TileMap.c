@@ -0,0 +1,197 @@
+#include "TileMap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Sparse maps start with room for this many tiles and double when full.
+#define TILE_MAP_INITIAL_CAPACITY 64
+
+static void allocateBuckets(TileMap* map, uint32_t bucketCount)
+{
+    map->bucketCount = bucketCount;
+    map->bucketShift = 64 - __builtin_ctz(bucketCount);
+    map->buckets = malloc(bucketCount * sizeof(TileBucket));
+
+    for (uint32_t b = 0; b < bucketCount; b++) {
+        map->buckets[b] = (TileBucket) {
+            .key = TILE_KEY_FREE, .slot = -1
+        };
+    }
+}
+
+// tiles is how many tiles the world is across and down. If that is at most
+// maxDenseTiles, every tile is stored up front and found without a lookup.
+TileMap createTileMap(size_t tileBytes, Size tiles, int maxDenseTiles)
+{
+    int64_t tileCount = (int64_t)tiles.w * tiles.h;
+
+    if (tileCount <= maxDenseTiles) {
+        TileMap map = {
+            .tileBytes = tileBytes,
+            .tiles = aligned_alloc(TILE_ALIGNMENT, (tileCount > 0 ? tileCount : 1) * tileBytes),
+            .capacity = (int)tileCount,
+            .dense = true,
+            .tilesAcross = tiles.w,
+            .used = (int)tileCount,
+            .freeSlot = -1,
+            .tileCount = (int)tileCount,
+            .peakTileCount = (int)tileCount,
+        };
+        memset(map.tiles, 0, tileCount * tileBytes);
+        return map;
+    }
+
+    TileMap map = {
+        .tileBytes = tileBytes,
+        .tiles = aligned_alloc(TILE_ALIGNMENT, TILE_MAP_INITIAL_CAPACITY * tileBytes),
+        .capacity = TILE_MAP_INITIAL_CAPACITY,
+        .dense = false,
+        .tileKeys = malloc(TILE_MAP_INITIAL_CAPACITY * sizeof(uint64_t)),
+        .nextFree = malloc(TILE_MAP_INITIAL_CAPACITY * sizeof(int)),
+        .used = 0,
+        .freeSlot = -1,
+        .tileCount = 0,
+        .peakTileCount = 0,
+    };
+    allocateBuckets(&map, 2 * TILE_MAP_INITIAL_CAPACITY);
+
+    return map;
+}
+
+void destroyTileMap(TileMap* map)
+{
+    free(map->tiles);
+    map->tiles = NULL;
+
+    free(map->tileKeys);
+    map->tileKeys = NULL;
+
+    free(map->nextFree);
+    map->nextFree = NULL;
+
+    free(map->buckets);
+    map->buckets = NULL;
+
+    map->capacity = 0;
+    map->used = 0;
+    map->tileCount = 0;
+}
+
+static void insertBucket(TileMap* map, uint64_t key, int slot)
+{
+    uint32_t mask = map->bucketCount - 1;
+    uint32_t b = getTileBucket(map, key);
+
+    while (map->buckets[b].slot != -1) {
+        b = (b + 1) & mask;
+    }
+
+    map->buckets[b] = (TileBucket) {
+        .key = key, .slot = slot
+    };
+}
+
+// Keeps the table at most half full, so that probes stay short.
+static void growBuckets(TileMap* map)
+{
+    TileBucket* old = map->buckets;
+    uint32_t oldCount = map->bucketCount;
+
+    allocateBuckets(map, oldCount * 2);
+    for (uint32_t b = 0; b < oldCount; b++) {
+        if (old[b].slot != -1) {
+            insertBucket(map, old[b].key, old[b].slot);
+        }
+    }
+
+    free(old);
+}
+
+static void growSlots(TileMap* map)
+{
+    char* tiles = aligned_alloc(TILE_ALIGNMENT, 2 * map->capacity * map->tileBytes);
+    memcpy(tiles, map->tiles, map->capacity * map->tileBytes);
+    free(map->tiles);
+    map->tiles = tiles;
+
+    map->capacity *= 2;
+    map->tileKeys = realloc(map->tileKeys, map->capacity * sizeof(uint64_t));
+    map->nextFree = realloc(map->nextFree, map->capacity * sizeof(int));
+}
+
+// Stores a zeroed tile at the tile coordinates of a sparse map, which must
+// not have one yet, and returns its slot.
+int addTile(TileMap* map, int32_t tileX, int32_t tileY)
+{
+    int slot = map->freeSlot;
+
+    if (slot != -1) {
+        map->freeSlot = map->nextFree[slot];
+    } else {
+        if (map->used == map->capacity) {
+            growSlots(map);
+        }
+        slot = map->used++;
+    }
+
+    if (2 * (uint32_t)(map->tileCount + 1) > map->bucketCount) {
+        growBuckets(map);
+    }
+
+    uint64_t key = getTileKey(tileX, tileY);
+    insertBucket(map, key, slot);
+    map->tileKeys[slot] = key;
+    memset(getTile(map, slot), 0, map->tileBytes);
+
+    map->tileCount++;
+    if (map->tileCount > map->peakTileCount) {
+        map->peakTileCount = map->tileCount;
+    }
+
+    return slot;
+}
+
+// Empties the tile's bucket. Later buckets in the same run are shifted back
+// over the hole, so that lookups never need tombstones.
+static void removeBucket(TileMap* map, int slot)
+{
+    uint32_t mask = map->bucketCount - 1;
+    uint32_t hole = getTileBucket(map, map->tileKeys[slot]);
+
+    while (map->buckets[hole].slot != slot) {
+        hole = (hole + 1) & mask;
+    }
+
+    for (uint32_t b = (hole + 1) & mask; map->buckets[b].slot != -1; b = (b + 1) & mask) {
+        uint32_t home = getTileBucket(map, map->buckets[b].key);
+
+        // a bucket can fill the hole if its home isn't between the hole and it
+        if (((b - home) & mask) >= ((b - hole) & mask)) {
+            map->buckets[hole] = map->buckets[b];
+            hole = b;
+        }
+    }
+    map->buckets[hole] = (TileBucket) {
+        .key = TILE_KEY_FREE, .slot = -1
+    };
+}
+
+// Forgets the tile in slot and keeps the slot for the next tile that is
+// added. The tiles of dense maps are kept, and must already be empty.
+void releaseTile(TileMap* map, int slot)
+{
+    if (map->dense) return;
+
+    removeBucket(map, slot);
+
+    map->tileKeys[slot] = TILE_KEY_FREE;
+    map->nextFree[slot] = map->freeSlot;
+    map->freeSlot = slot;
+    map->tileCount--;
+}
+
+size_t getTileMapBytes(TileMap* map)
+{
+    size_t slotBytes = map->dense ? map->tileBytes : map->tileBytes + sizeof(uint64_t) + sizeof(int);
+    return map->capacity * slotBytes + map->bucketCount * sizeof(TileBucket);
+}
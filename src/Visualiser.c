@@ -5,7 +5,10 @@
 #if FEATURE_VISUALISER
 
 #include "LineGraph.h"
+#include "ObstacleMap.h"
+#include "NeuralNet.h"
 #include "Organism.h"
+#include "OrganismStore.h"
 #include "Simulator.h"
 #include "Visualiser.h"
 #include <SDL2/SDL.h>
@@ -49,14 +52,18 @@ static float previousSurvivalRate = -1.0f;
 static volatile bool interrupted = false;
 static Simulation *sim;
 
-static Organism* drawableOrgsRead;
-static volatile Organism* drawableOrgsWrite;
+static OrganismStore drawableOrgsRead;
+static OrganismStore drawableOrgsWrite;
 static volatile Neuron* neuronBackBuffer;
 static volatile NeuralConnection * connectionBackBuffer;
 static volatile Gene* geneBackBuffer;
 static Neuron* neuronFrontBuffer;
 static NeuralConnection * connectionFrontBuffer;
 static Gene* geneFrontBuffer;
+
+// room for each organism's net in the buffers above, sized to the genome
+static size_t neuronStride;
+static size_t connectionStride;
 static volatile bool drawableOrgsStepChanged;
 static volatile bool drawableOrgsGenerationChanged;
 static volatile bool drawableOrgsWriteablePopulated;
@@ -145,13 +152,17 @@ void visInit(uint32_t w, uint32_t h)
     graphPos.y += 65;
     survivalRatesEachStep = createLineGraph(sim->stepsPerGeneration, (SDL_Color){.r = 255, .g = 0, .b = 0, .a = 255 }, graphPos, graphSize);
 
-    neuronBackBuffer = calloc(MAX_NEURONS * sim->population, sizeof(Neuron));
-    connectionBackBuffer = calloc(MAX_CONNECTIONS * sim->population, sizeof(NeuralConnection));
-    geneBackBuffer = calloc(sim->numberOfGenes * sim->population, sizeof(Gene));
+    // a net has one connection per gene
+    neuronStride = getMaxNeuronCount(sim->numberOfGenes);
+    connectionStride = sim->numberOfGenes;
+
+    neuronBackBuffer = calloc(neuronStride * sim->population, sizeof(Neuron));
+    connectionBackBuffer = calloc(connectionStride * sim->population, sizeof(NeuralConnection));
+    geneBackBuffer = calloc((size_t)sim->numberOfGenes * sim->population, sizeof(Gene));
 
-    neuronFrontBuffer = calloc(MAX_NEURONS * sim->population, sizeof(Neuron));
-    connectionFrontBuffer = calloc(MAX_CONNECTIONS * sim->population, sizeof(NeuralConnection));
-    geneFrontBuffer = calloc(sim->numberOfGenes * sim->population, sizeof(Gene));
+    neuronFrontBuffer = calloc(neuronStride * sim->population, sizeof(Neuron));
+    connectionFrontBuffer = calloc(connectionStride * sim->population, sizeof(NeuralConnection));
+    geneFrontBuffer = calloc((size_t)sim->numberOfGenes * sim->population, sizeof(Gene));
     
     visDrawShell();
     SDL_RenderPresent(renderer);
@@ -259,7 +270,8 @@ void visDrawShell(void)
     drawShellText(13, gray, "Seed: %'d", sim->seed);
     drawShellText(14, gray, "Int. Neurons: %d", sim->maxInternalNeurons);
     drawShellText(15, gray, "No. of Genes: %d", sim->numberOfGenes);
-    drawShellText(16, gray, "Mut. Rate: %.2f%%", sim->mutationRate * 100.0f);
+    drawShellText(16, gray, "Mut. Rates: %.2f/%.2f/%.2f%%", sim->mutationRates.bitFlip * 100.0f,
+                  sim->mutationRates.weightPerturbation * 100.0f, sim->mutationRates.duplication * 100.0f);
     drawShellText(17, gray, "Gen. Pop.: %'d", sim->population);
     drawShellText(18, gray, "Gen. Count: %'d", sim->maxGenerations);
 
@@ -285,17 +297,29 @@ void visDrawShell(void)
     renderLineGraph(&survivalRatesEachGeneration, renderer);
     drawTextAt(smallFont, (Pos){.x = survivalRatesEachGeneration.pos.x + 2, .y = survivalRatesEachGeneration.pos.y - 16}, black, "Survival Rate (per Generation)");
 
-    // obstacles
-    for (int i = 0; i < sim->obstaclesCount; i++) {
-        Rect *r = &sim->obstacles[i];
-        SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-        SDL_RenderFillRect(renderer,
-        &(SDL_Rect) {
-            .x = paddingLeft + r->x * SIM_SCALE,
-            .y = paddingTop + r->y * SIM_SCALE,
-            .w = r->w * SIM_SCALE,
-            .h = r->h * SIM_SCALE
-        });
+    // obstacles, drawn as one rect per horizontal run of blocked cells
+    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+    for (int y = 0; y < simH; y++) {
+        int x = 0;
+        while (x < simW) {
+            if (!isPosBlocked(&sim->obstacleMap, (Pos){.x = x, .y = y})) {
+                x++;
+                continue;
+            }
+
+            int runStart = x;
+            while (x < simW && isPosBlocked(&sim->obstacleMap, (Pos){.x = x, .y = y})) {
+                x++;
+            }
+
+            SDL_RenderFillRect(renderer,
+            &(SDL_Rect) {
+                .x = paddingLeft + runStart * SIM_SCALE,
+                .y = paddingTop + y * SIM_SCALE,
+                .w = (x - runStart) * SIM_SCALE,
+                .h = SIM_SCALE
+            });
+        }
     }
 }
 
@@ -340,24 +364,27 @@ void handleEvents()
     }
 }
 
-SDL_Color getOrganismBaseColor(Organism* org)
+SDL_Color getOrganismBaseColor(OrganismStore* orgs, int i)
 {
+    bool alive = isOrganismAlive(orgs, i);
+    bool mutated = getOrganism(orgs, i)->mutated;
+
     // alive and mutated = bright green
-    if (org->alive && org->mutated) {
+    if (alive && mutated) {
         return (SDL_Color) {
             .r = 0, .g = 255, .b = 0, .a = 255
         };
     }
 
     // alive and not-mutated = white
-    if (org->alive && !org->mutated) {
+    if (alive && !mutated) {
         return (SDL_Color) {
             .r = 255, .g = 255, .b = 255, .a = 255
         };
     }
 
     // not-alive and mutated = gray
-    if (!org->alive && org->mutated) {
+    if (!alive && mutated) {
         return (SDL_Color) {
             .r = 128, .g = 128, .b = 128, .a = 255
         };
@@ -379,9 +406,10 @@ void copyBackbufferToFrontBuffer(void)
     sem_wait(&drawableOrgsLock);
 
     for (int i = 0; i < sim->population; i++) {
-        destroyOrganism(&drawableOrgsRead[i]);
-        drawableOrgsRead[i] = copyOrganism((Organism*)&drawableOrgsWrite[i], &neuronFrontBuffer[i * MAX_NEURONS], &connectionFrontBuffer[i * MAX_CONNECTIONS], &geneFrontBuffer[i * sim->numberOfGenes]);
+        destroyOrganism(getOrganism(&drawableOrgsRead, i));
+        *getOrganism(&drawableOrgsRead, i) = copyOrganism(getOrganism(&drawableOrgsWrite, i), &neuronFrontBuffer[i * neuronStride], &connectionFrontBuffer[i * connectionStride], &geneFrontBuffer[(size_t)i * sim->numberOfGenes]);
     }
+    copyOrganismStoreState(&drawableOrgsRead, &drawableOrgsWrite);
     drawableOrgsGenerationChanged = false;
     drawableOrgsStepChanged = false;
     drawableOrgsReadablePopulated = true;
@@ -407,39 +435,39 @@ void visDrawStep(void)
     if (drawableOrgsReadablePopulated) {
         // SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
         for (int i = 0; i < sim->population; i++) {
-            Organism *org = &drawableOrgsRead[i];
-            SDL_Color color = getOrganismBaseColor(org);
+            Pos pos = getOrganismPos(&drawableOrgsRead, i);
+            SDL_Color color = getOrganismBaseColor(&drawableOrgsRead, i);
 
             setRenderDrawColor(color);
             SDL_RenderFillRect(renderer, &(SDL_Rect){
-                .x = paddingLeft + SIM_SCALE * org->pos.x,
-                .y = paddingTop + SIM_SCALE * org->pos.y,
+                .x = paddingLeft + SIM_SCALE * pos.x,
+                .y = paddingTop + SIM_SCALE * pos.y,
                 .w = SIM_SCALE,
                 .h = SIM_SCALE
             });
-            // SDL_RenderDrawPoint(renderer, paddingLeft + SIM_SCALE * org->pos.x + 1, paddingTop + SIM_SCALE * org->pos.y + 1);
+            // SDL_RenderDrawPoint(renderer, paddingLeft + SIM_SCALE * pos.x + 1, paddingTop + SIM_SCALE * pos.y + 1);
 
             // SDL_Point fullPoints[4] = {
-            //     (SDL_Point){.x = paddingLeft + SIM_SCALE * org->pos.x + 1, .y = paddingTop + SIM_SCALE * org->pos.y},
-            //     (SDL_Point){.x = paddingLeft + SIM_SCALE * org->pos.x + 1, .y = paddingTop + SIM_SCALE * org->pos.y + 2},
-            //     (SDL_Point){.x = paddingLeft + SIM_SCALE * org->pos.x, .y = paddingTop + SIM_SCALE * org->pos.y + 1},
-            //     (SDL_Point){.x = paddingLeft + SIM_SCALE * org->pos.x + 2, .y = paddingTop + SIM_SCALE * org->pos.y + 1},
+            //     (SDL_Point){.x = paddingLeft + SIM_SCALE * pos.x + 1, .y = paddingTop + SIM_SCALE * pos.y},
+            //     (SDL_Point){.x = paddingLeft + SIM_SCALE * pos.x + 1, .y = paddingTop + SIM_SCALE * pos.y + 2},
+            //     (SDL_Point){.x = paddingLeft + SIM_SCALE * pos.x, .y = paddingTop + SIM_SCALE * pos.y + 1},
+            //     (SDL_Point){.x = paddingLeft + SIM_SCALE * pos.x + 2, .y = paddingTop + SIM_SCALE * pos.y + 1},
             // };
             // color.a = 128;
             // setRenderDrawColor(color);
             // SDL_RenderDrawPoints(renderer, fullPoints, 4);
 
             // fullPoints[0] = (SDL_Point) {
-            //     .x = paddingLeft + SIM_SCALE * org->pos.x, .y = paddingTop + SIM_SCALE * org->pos.y
+            //     .x = paddingLeft + SIM_SCALE * pos.x, .y = paddingTop + SIM_SCALE * pos.y
             // };
             // fullPoints[1] = (SDL_Point) {
-            //     .x = paddingLeft + SIM_SCALE * org->pos.x, .y = paddingTop + SIM_SCALE * org->pos.y + 2
+            //     .x = paddingLeft + SIM_SCALE * pos.x, .y = paddingTop + SIM_SCALE * pos.y + 2
             // };
             // fullPoints[2] = (SDL_Point) {
-            //     .x = paddingLeft + SIM_SCALE * org->pos.x + 2, .y = paddingTop + SIM_SCALE * org->pos.y + 2
+            //     .x = paddingLeft + SIM_SCALE * pos.x + 2, .y = paddingTop + SIM_SCALE * pos.y + 2
             // };
             // fullPoints[3] = (SDL_Point) {
-            //     .x = paddingLeft + SIM_SCALE * org->pos.x + 2, .y = paddingTop + SIM_SCALE * org->pos.y
+            //     .x = paddingLeft + SIM_SCALE * pos.x + 2, .y = paddingTop + SIM_SCALE * pos.y
             // };
             // color.a = 32;
             // setRenderDrawColor(color);
@@ -520,37 +548,32 @@ void visDestroy(void)
     SDL_Quit();
 }
 
-float calculateSurvivalRate(Organism* orgs)
+float calculateSurvivalRate(OrganismStore* orgs)
 {
-    int survivors = 0;
-    for (int i = 0; i < sim->population; i++) {
-        if (orgs[i].alive) {
-            survivors++;
-        }
-    }
-    return 100.0f * (float)survivors / (float)sim->population;
+    return 100.0f * (float)countLivingOrganisms(orgs) / (float)sim->population;
 }
 
-void copyOrganismsToBackbuffer(Organism* orgs)
+void copyOrganismsToBackbuffer(OrganismStore* orgs)
 {
     sem_wait(&drawableOrgsLock);
 
     if (drawableOrgsWriteablePopulated) {
         for (int i = 0; i < sim->population; i++) {
-            destroyOrganism((Organism*)&drawableOrgsWrite[i]);
+            destroyOrganism(getOrganism(&drawableOrgsWrite, i));
         }
     }
 
     for (int i = 0; i < sim->population; i++) {
-        drawableOrgsWrite[i] = copyOrganism(&orgs[i], (Neuron*)&neuronBackBuffer[i * MAX_NEURONS], (NeuralConnection*)&connectionBackBuffer[i * MAX_CONNECTIONS], (Gene*)&geneBackBuffer[i * sim->numberOfGenes]);
+        *getOrganism(&drawableOrgsWrite, i) = copyOrganism(getOrganism(orgs, i), (Neuron*)&neuronBackBuffer[i * neuronStride], (NeuralConnection*)&connectionBackBuffer[i * connectionStride], (Gene*)&geneBackBuffer[(size_t)i * sim->numberOfGenes]);
     }
+    copyOrganismStoreState(&drawableOrgsWrite, orgs);
 
     drawableOrgsWriteablePopulated = true;
 
     sem_post(&drawableOrgsLock);
 }
 
-void visSendGeneration(Organism *orgs, int g)
+void visSendGeneration(OrganismStore *orgs, int g)
 {
     TRACE_BEGIN;
 
@@ -590,7 +613,7 @@ void visSendQuit(void)
     TRACE_END;
 }
 
-void visSendStep(Organism* orgs, int s)
+void visSendStep(OrganismStore* orgs, int s)
 {
     TRACE_BEGIN;
 
@@ -607,15 +630,13 @@ void visSendStep(Organism* orgs, int s)
     sem_wait(&drawableOrgsLock);
 
     if (drawableOrgsWriteablePopulated) {
-        for (int i = 0; i < sim->population; i++) {
-            // this time only change the data that can change during execution
-            copyOrganismMutableState((Organism*)&drawableOrgsWrite[i], &orgs[i]);
-        }
+        // this time only change the data that can change during execution
+        copyOrganismStoreState(&drawableOrgsWrite, orgs);
         drawableOrgsStepChanged = true;
 
         step = s;
 
-        survivalRate = calculateSurvivalRate((Organism*)drawableOrgsWrite);
+        survivalRate = calculateSurvivalRate(&drawableOrgsWrite);
 
         setPointOnGraph(&survivalRatesEachStep, step, survivalRate / 100.0f);
         setPointOnGraph(&survivalRatesEachGeneration, generation, survivalRate / 100.0f);
@@ -638,8 +659,8 @@ void runUserInterface(Simulation* s)
 {
     sim = s;
 
-    drawableOrgsWrite = calloc(sim->population, sizeof(Organism));
-    drawableOrgsRead = calloc(sim->population, sizeof(Organism));
+    drawableOrgsWrite = createOrganismStore(sim->population);
+    drawableOrgsRead = createOrganismStore(sim->population);
     sem_init(&drawableOrgsLock, 0, 1);
 
     drawableOrgsStepChanged = false;
@@ -680,20 +701,18 @@ void runUserInterface(Simulation* s)
 
     if (drawableOrgsReadablePopulated) {
         for (int i = 0; i < sim->population; i++) {
-            destroyOrganism(&drawableOrgsRead[i]);
+            destroyOrganism(getOrganism(&drawableOrgsRead, i));
         }
         drawableOrgsReadablePopulated = false;
-        free(drawableOrgsRead);
-        drawableOrgsRead = NULL;
+        destroyOrganismStore(&drawableOrgsRead);
     }
 
     if (drawableOrgsWriteablePopulated) {
         for (int i = 0; i < sim->population; i++) {
-            destroyOrganism((Organism*)&drawableOrgsWrite[i]);
+            destroyOrganism(getOrganism(&drawableOrgsWrite, i));
         }
         drawableOrgsWriteablePopulated = false;
-        free((void*)drawableOrgsWrite);
-        drawableOrgsWrite = NULL;
+        destroyOrganismStore(&drawableOrgsWrite);
     }
 
     sem_destroy(&drawableOrgsLock);
@@ -709,8 +728,8 @@ void visSendReady(void)
 
 #else
 
-void visSendGeneration(Organism *orgs, int generation) {}
-void visSendStep(Organism *orgs, int step) {}
+void visSendGeneration(OrganismStore *orgs, int generation) {}
+void visSendStep(OrganismStore *orgs, int step) {}
 void visSendQuit(void) {}
 void visSendReady(void) {}
 void runUserInterface(Simulation *sim) {}